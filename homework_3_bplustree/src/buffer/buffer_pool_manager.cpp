@@ -1,75 +1,165 @@
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "common/epoch_manager.h"
 
 namespace scudb {
 
+/*
+ * helper function to build the replacer for the given replacement policy
+ */
+static Replacer<Page *> *NewReplacer(ReplacerType replacer_type) {
+  switch (replacer_type) {
+  case ReplacerType::LRU_K:
+    return new LRUKReplacer<Page *>(LRUK_REPLACER_K);
+  case ReplacerType::LRU:
+  default:
+    return new LRUReplacer<Page *>;
+  }
+}
+
 /*
  * BufferPoolManager Constructor
  * When log_manager is nullptr, logging is disabled (for test purpose)
- * WARNING: Do Not Edit This Function
+ * replacer_type chooses the replacement policy used to pick victim frames
  */
 BufferPoolManager::BufferPoolManager(size_t pool_size,
                                                  DiskManager *disk_manager,
-                                                 LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager),
-      log_manager_(log_manager) {
-  // a consecutive memory space for buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-  replacer_ = new LRUReplacer<Page *>;
+                                                 LogManager *log_manager,
+                                                 ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      frame_slab_(new FrameSlab(PAGE_SIZE, ENABLE_HUGE_PAGES)),
+      disk_manager_(disk_manager), log_manager_(log_manager) {
+  // frames are allocated one by one, so the pool can grow and shrink
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_.push_back(new Page(frame_slab_->Allocate()));
+  }
+  page_table_ = new PageTable(pool_size_);
+  replacer_ = NewReplacer(replacer_type);
   free_list_ = new std::list<Page *>;
 
   // put all the pages into free list
   for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_->push_back(&pages_[i]);
+    free_list_->push_back(pages_[i]);
   }
 }
 
+/*
+ * Constructor for subclasses that manage their frames elsewhere (e.g.
+ * ParallelBufferPoolManager), this instance owns no frame at all
+ */
+BufferPoolManager::BufferPoolManager(DiskManager *disk_manager,
+                                     LogManager *log_manager)
+    : pool_size_(0), frame_slab_(nullptr), disk_manager_(disk_manager),
+      log_manager_(log_manager), page_table_(nullptr), replacer_(nullptr),
+      free_list_(nullptr) {}
+
 /*
  * BufferPoolManager Deconstructor
- * WARNING: Do Not Edit This Function
+ * Stop the page cleaner and wait for in-flight prefetches, nothing touches
+ * the frames afterwards. Then free the frames, retired ones included, the
+ * page table, the replacer, the free list, the victim cache, the free space
+ * map, which the disk manager forgets first, and the frame slab last: the
+ * frames point into it. Dirty pages are not flushed, see FlushAllPages()
  */
 BufferPoolManager::~BufferPoolManager() {
-  delete[] pages_;
+  StopCleanerThread();
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    prefetch_cv_.wait(lock, [&] { return prefetching_ == 0; });
+  }
+  for (auto *page : pages_) {
+    delete page;
+  }
+  for (auto *page : retired_) {
+    delete page;
+  }
   delete page_table_;
   delete replacer_;
   delete free_list_;
+  delete victim_cache_.load();
+  if (free_space_map_ != nullptr) {
+    disk_manager_->SetFreeSpaceMap(nullptr);
+    delete free_space_map_;
+  }
+  delete frame_slab_;
 }
 
 /**
+ * 0. a resident, loaded page is pinned without latch_, unless its frame is
+ *    being replaced or freed
  * 1. search hash table.
- *  1.1 if exist, pin the page and return immediately
- *  1.2 if no exist, find a replacement entry from either free list or lru
- *      replacer. (NOTE: always find from free list first)
- * 2. If the entry chosen for replacement is dirty, write it back to disk.
- * 3. Delete the entry for the old page from the hash table and insert an
- * entry for the new page.
- * 4. Update page metadata, read page content from disk file and return page
- * pointer
- */
-Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-        std::lock_guard<std::mutex> guard(latch_);
+ *  1.1 if exist, pin the page, wait for its pending I/O and return
+ *  1.2 if the page is still being written back from a frame it was evicted
+ *      from, wait for that frame and search again
+ *  1.3 if no exist, find a replacement entry from either free list or lru
+ *      replacer. (NOTE: always find from free list first). With a strategy,
+ *      recycle a frame of its ring first
+ * 2. Delete the entry for the old page from the hash table and insert an
+ * entry for the new page, marking the frame as I/O in progress.
+ * 3. Release the latch, write the old content back if it is dirty, read page
+ * content from disk file and return page pointer
+ */
+Page *BufferPoolManager::FetchPage(page_id_t page_id,
+                                   BufferAccessStrategy *strategy) {
+    auto start = BufferPoolMetrics::clock::now();
     Page *Select_page = nullptr;
-    if(page_table_->Find(page_id, Select_page)){
-        Select_page->pin_count_++;
-        replacer_->Erase(Select_page);
+    if(page_table_->Find(page_id, Select_page) &&
+       TryPinResident(Select_page, page_id)){
+        metrics_.Add(StatCounter::FETCH_HIT);
+        metrics_.Record(StatLatency::FETCH_PAGE, start);
         return Select_page;
-    }else if(!free_list_->empty()){
-        Select_page = free_list_->front();
-        free_list_->pop_front();
-    }else{
-        if(!replacer_->Victim(Select_page)){
+    }
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
+    while(true){
+        if(page_table_->Find(page_id, Select_page)){
+            Select_page->pin_count_++;
+            replacer_->Pin(Select_page);
+            WaitForIO(Select_page, lock);
+            metrics_.Add(StatCounter::FETCH_HIT);
+            metrics_.Record(StatLatency::FETCH_PAGE, start);
+            return Select_page;
+        }
+        auto writing = writing_back_.find(page_id);
+        if(writing != writing_back_.end()){
+            Page *frame = writing->second;
+            frame->io_cv_.wait(lock, [&] { return frame->evicted_page_id_ != page_id; });
+            continue;
+        }
+        Select_page = nullptr;
+        if(strategy != nullptr){
+            Select_page = GetRingVictim(strategy, false);
+        }
+        if(Select_page == nullptr){
+            Select_page = GetVictimPage(lock);
+        }
+        if(Select_page == nullptr){
             return nullptr;
         }
+        // latch_ may have been released, check nobody brought page_id in
+        Page *resident = nullptr;
+        if(!page_table_->Find(page_id, resident) &&
+           writing_back_.find(page_id) == writing_back_.end()){
+            break;
+        }
+        if(Select_page->page_id_ == INVALID_PAGE_ID){
+            free_list_->push_front(Select_page);
+        }else{
+            Select_page->pin_count_ = 0;
+            replacer_->Insert(Select_page);
+        }
     }
-    if(Select_page->is_dirty_){
-        disk_manager_->WritePage(Select_page->page_id_, Select_page->GetData());
+    ReplaceFrame(Select_page, page_id);
+    if(strategy != nullptr){
+        AddToRing(strategy, Select_page);
     }
-    page_table_->Remove(Select_page->page_id_);
-    page_table_->Insert(page_id, Select_page);
-    Select_page->page_id_ = page_id;
-    Select_page->is_dirty_ = false;
-    Select_page->pin_count_ = 1;
-    disk_manager_->ReadPage(page_id, Select_page->GetData());
+    lock.unlock();
+    LoadFrame(Select_page, true);
+    metrics_.Add(StatCounter::FETCH_MISS);
+    metrics_.Record(StatLatency::FETCH_PAGE, start);
     return Select_page;
 }
 
@@ -80,62 +170,345 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
  * dirty flag of this page
  */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-    std::lock_guard<std::mutex> guard(latch_);
+    auto start = BufferPoolMetrics::clock::now();
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
     Page *Select_page = nullptr;
     if(!page_table_->Find(page_id, Select_page)){
         return false;
     }
-    if(Select_page->pin_count_ > 0){
-        --Select_page->pin_count_;
-        if(!Select_page->pin_count_ ){
-            replacer_->Insert(Select_page);
-        }
-    }else{
+    if(Select_page->pin_count_ <= 0){
         return false;
     }
     if(is_dirty){
         Select_page->is_dirty_ = true;
     }
+    bool deallocate = false;
+    // latch free fetchers may pin concurrently, test what the decrement left
+    if(--Select_page->pin_count_ == 0){
+        deallocate = ReleaseFrame(Select_page, lock);
+    }
+    lock.unlock();
+    if(deallocate){
+        disk_manager_->DeallocatePage(page_id);
+    }
+    metrics_.Add(StatCounter::UNPIN);
+    metrics_.Record(StatLatency::UNPIN_PAGE, start);
     return true;
 }
 
+/*
+ * Unpin a frame the caller holds a pin on, so it cannot change page meanwhile.
+ * Any pin but the last one is dropped with a compare and swap. The last one
+ * takes latch_, the frame goes back to the replacer, or is freed if its page
+ * was deleted; latch free fetchers may pin it again before latch_ is taken
+ */
+bool BufferPoolManager::UnpinPage(Page *Select_page, bool is_dirty) {
+    auto start = BufferPoolMetrics::clock::now();
+    int pin_count = Select_page->pin_count_.load();
+    if(pin_count <= 0){
+        return false;
+    }
+    if(is_dirty){
+        Select_page->is_dirty_ = true;
+    }
+    while(pin_count > 1){
+        if(Select_page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)){
+            metrics_.Add(StatCounter::UNPIN);
+            metrics_.Record(StatLatency::UNPIN_PAGE, start);
+            return true;
+        }
+    }
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
+    if(Select_page->pin_count_ <= 0){
+        return false;
+    }
+    page_id_t page_id = Select_page->page_id_;
+    bool deallocate = false;
+    if(--Select_page->pin_count_ == 0){
+        deallocate = ReleaseFrame(Select_page, lock);
+    }
+    lock.unlock();
+    if(deallocate){
+        disk_manager_->DeallocatePage(page_id);
+    }
+    metrics_.Add(StatCounter::UNPIN);
+    metrics_.Record(StatLatency::UNPIN_PAGE, start);
+    return true;
+}
+
+/*
+ * Guarded fetches: the frame returned by FetchPage() is latched and handed to
+ * the guard with its pin, nothing is looked up again to release it
+ */
+ReadPageGuard BufferPoolManager::FetchPageRead(page_id_t page_id,
+                                               BufferAccessStrategy *strategy) {
+    return ReadPageGuard(this, FetchPage(page_id, strategy));
+}
+
+WritePageGuard BufferPoolManager::FetchPageWrite(page_id_t page_id) {
+    return WritePageGuard(this, FetchPage(page_id));
+}
+
+WritePageGuard BufferPoolManager::NewPageGuarded(page_id_t &page_id) {
+    WritePageGuard guard(this, NewPage(page_id));
+    guard.SetDirty();
+    return guard;
+}
+
+/*
+ * Lock free. A frame changes hands only after its latch version was bumped,
+ * so once the version is read, finding page_id loaded in the frame means the
+ * content is page_id's until the version moves again. The same check makes a
+ * swizzled frame safe to follow: it is only a hint, stale once the frame was
+ * evicted, and then the page table is searched
+ */
+Page *BufferPoolManager::FetchPageOptimistic(page_id_t page_id, uint64_t &version,
+                                             Page *swizzled) {
+    if(swizzled != nullptr && swizzled->TryRLatchOptimistic(version) &&
+       swizzled->page_id_ == page_id && !swizzled->io_in_progress_){
+        return swizzled;
+    }
+    Page *Select_page = nullptr;
+    if(!page_table_->Find(page_id, Select_page) ||
+       !Select_page->TryRLatchOptimistic(version)){
+        return nullptr;
+    }
+    if(Select_page->page_id_ != page_id || Select_page->io_in_progress_){
+        return nullptr;
+    }
+    return Select_page;
+}
+
 /*
  * Used to flush a particular page of the buffer pool to disk. Should call the
- * write_page method of the disk manager
+ * write_page method of the disk manager, only if the page is dirty, and clear
+ * its dirty flag
  * if page is not found in page table, return false
  * NOTE: make sure page_id != INVALID_PAGE_ID
  */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
-        std::lock_guard<std::mutex> guard(latch_);
+    std::unique_lock<std::mutex> lock(latch_);
     Page *Select_page = nullptr;
+    // the frame is not pinned by us, look it up again after waiting
+    while(page_table_->Find(page_id, Select_page) &&
+          Select_page->io_in_progress_){
+        Select_page->io_cv_.wait(lock);
+    }
     if(page_table_->Find(page_id, Select_page)){
-        disk_manager_->WritePage(page_id, Select_page->GetData());
+        if(Select_page->is_dirty_){
+            WriteToDisk(page_id, Select_page->GetData());
+            Select_page->is_dirty_ = false;
+        }
         return true;
     }
     return false;
 }
 
+/*
+ * Checkpoint the buffer pool: collect the dirty frames, sort them by page id
+ * and write each run of consecutive pages with a single disk write, without
+ * holding latch_. Frames being written are I/O in progress, like frames the
+ * page cleaner writes, so they cannot be evicted meanwhile
+ */
+FlushStats BufferPoolManager::FlushAllPages() {
+    std::vector<Page *> dirty_pages;
+    std::vector<Page *> busy_pages;
+    FlushStats stats;
+    BeginFlush(dirty_pages, busy_pages);
+    WritePageRuns(disk_manager_, dirty_pages, stats);
+    EndFlush(dirty_pages, busy_pages);
+    disk_manager_->Sync();
+    return stats;
+}
+
+void BufferPoolManager::BeginFlush(std::vector<Page *> &dirty_pages,
+                                   std::vector<Page *> &busy_pages) {
+    std::lock_guard<std::mutex> guard(latch_);
+    for(auto *Select_page : pages_){
+        if(Select_page->io_in_progress_){
+            // a write-back or a page cleaner write still in flight
+            busy_pages.push_back(Select_page);
+        }else if(Select_page->is_dirty_){
+            Select_page->is_dirty_ = false;
+            Select_page->io_in_progress_ = true;
+            dirty_pages.push_back(Select_page);
+        }
+    }
+}
+
+void BufferPoolManager::EndFlush(const std::vector<Page *> &dirty_pages,
+                                 const std::vector<Page *> &busy_pages) {
+    std::unique_lock<std::mutex> lock(latch_);
+    // written by runs, counted but not timed one by one
+    metrics_.Add(StatCounter::DISK_WRITE, dirty_pages.size());
+    for(auto *Select_page : dirty_pages){
+        Select_page->io_in_progress_ = false;
+        Select_page->io_cv_.notify_all();
+    }
+    for(auto *Select_page : busy_pages){
+        WaitForIO(Select_page, lock);
+    }
+}
+
+/*
+ * Write pages back in page id order. Pages with consecutive ids are handed to
+ * the disk manager together, so a checkpoint turns into a few sequential
+ * writes instead of one random write per page. All the runs are queued at
+ * once, then waited for
+ */
+void BufferPoolManager::WritePageRuns(DiskManager *disk_manager,
+                                      std::vector<Page *> &pages,
+                                      FlushStats &stats) {
+    std::sort(pages.begin(), pages.end(), [](Page *a, Page *b) {
+        return a->GetPageId() < b->GetPageId();
+    });
+    std::mutex latch;
+    std::condition_variable done_cv;
+    size_t pending = 0;
+    std::vector<const char *> run;
+    for(size_t i = 0; i < pages.size(); ++i){
+        run.push_back(pages[i]->GetData());
+        if(i + 1 < pages.size() &&
+           pages[i + 1]->GetPageId() == pages[i]->GetPageId() + 1){
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> guard(latch);
+            ++pending;
+        }
+        disk_manager->WritePagesAsync(pages[i]->GetPageId() + 1 - run.size(), run,
+                                      [&] {
+            std::lock_guard<std::mutex> guard(latch);
+            if(--pending == 0){
+                done_cv.notify_all();
+            }
+        });
+        stats.num_pages += run.size();
+        stats.num_bytes += run.size() * PAGE_SIZE;
+        ++stats.num_writes;
+        run.clear();
+    }
+    std::unique_lock<std::mutex> lock(latch);
+    done_cv.wait(lock, [&] { return pending == 0; });
+}
+
 /**
  * User should call this method for deleting a page. This routine will call
  * disk manager to deallocate the page. First, if page is found within page
  * table, buffer pool manager should be reponsible for removing this entry out
  * of page table, reseting page metadata and adding back to free list. Second,
  * call disk manager's DeallocatePage() method to delete from disk file. If
- * the page is found within page table, but pin_count != 0, return false
+ * the page is still pinned, its frame and the page are freed on the last
+ * unpin instead. return false for INVALID_PAGE_ID
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-        std::lock_guard<std::mutex> guard(latch_);
-    Page *Select_page = nullptr;
-    if(page_table_->Find(page_id, Select_page)){
-        page_table_->Remove(page_id);
-        Select_page->page_id_ = INVALID_PAGE_ID;
-        Select_page->is_dirty_ = false;
-        replacer_->Erase(Select_page);
+    if(page_id == INVALID_PAGE_ID){
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(latch_);
+    bool deallocate = DropPage(page_id, lock);
+    // the free space map fetches a bitmap page
+    lock.unlock();
+    if(deallocate){
         disk_manager_->DeallocatePage(page_id);
-        free_list_->push_back(Select_page);
-        return true;
     }
-    return false;
+    return true;
+}
+
+/*
+ * Take page_id out of the pool. A resident frame is waited for while under
+ * I/O, then freed, or marked to be freed on its last unpin if pinned. A copy
+ * being written back is waited for too, it must not land over the next owner
+ * of the page id, and the victim cache forgets it.
+ * Caller must hold latch_ through lock, which may be released meanwhile.
+ * return true if the page is to be deallocated, once latch_ is released
+ */
+bool BufferPoolManager::DropPage(page_id_t page_id,
+                                 std::unique_lock<std::mutex> &lock) {
+    while(true){
+        Page *Select_page = nullptr;
+        if(page_table_->Find(page_id, Select_page)){
+            // the page cleaner may be writing the frame, wait before freeing it
+            if(Select_page->io_in_progress_){
+                Select_page->io_cv_.wait(lock);
+                continue;
+            }
+            if(!ClaimFrame(Select_page)){
+                Select_page->delete_on_unpin_ = true;
+                return false;
+            }
+            FreeFrame(Select_page);
+            break;
+        }
+        auto writing = writing_back_.find(page_id);
+        if(writing != writing_back_.end()){
+            Page *frame = writing->second;
+            frame->io_cv_.wait(lock, [&] { return frame->evicted_page_id_ != page_id; });
+            continue;
+        }
+        break;
+    }
+    CompressedPageCache *victim_cache = victim_cache_.load();
+    if(victim_cache != nullptr){
+        victim_cache->Erase(page_id);
+    }
+    return true;
+}
+
+/*
+ * Unmap the claimed, idle frame from its page and put it on the free list.
+ * Caller must hold latch_
+ */
+void BufferPoolManager::FreeFrame(Page *Select_page) {
+    InvalidateFrame(Select_page);
+    Select_page->Unswizzle();
+    page_table_->Remove(Select_page->page_id_);
+    Select_page->page_id_ = INVALID_PAGE_ID;
+    Select_page->is_dirty_ = false;
+    Select_page->delete_on_unpin_ = false;
+    Select_page->hits_ = 0;
+    replacer_->Erase(Select_page);
+    free_list_->push_back(Select_page);
+}
+
+/*
+ * Take an unpinned frame out of the replacer for this thread, to replace or
+ * free it: pin_count_ goes from 0 to -1, so latch free fetchers can no longer
+ * pin it. If one pinned it first, the frame is no victim until its last
+ * unpin, the replacer gets its hits so far.
+ * Caller must hold latch_
+ * return false if the frame is pinned
+ */
+bool BufferPoolManager::ClaimFrame(Page *Select_page) {
+    int pin_count = 0;
+    if(!Select_page->pin_count_.compare_exchange_strong(pin_count, -1)){
+        replacer_->PinHits(Select_page, Select_page->hits_.exchange(0));
+        return false;
+    }
+    replacer_->Erase(Select_page);
+    return true;
+}
+
+/*
+ * The last pin of the frame is gone: back into the replacer, with the page
+ * table hits it did not see, unless its page was deleted while pinned, then
+ * drop it. Caller must hold latch_ through lock, which may be released
+ * meanwhile.
+ * return true if the page is to be deallocated, once latch_ is released
+ */
+bool BufferPoolManager::ReleaseFrame(Page *Select_page,
+                                     std::unique_lock<std::mutex> &lock) {
+    if(!Select_page->delete_on_unpin_){
+        uint32_t hits = Select_page->hits_.exchange(0);
+        if(hits > 0){
+            replacer_->PinHits(Select_page, hits);
+        }
+        replacer_->Insert(Select_page);
+        return false;
+    }
+    return DropPage(Select_page->page_id_, lock);
 }
 
 /**
@@ -147,26 +520,752 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * into page table. return nullptr if all the pages in pool are pinned
  */
 Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+    if(free_space_map_ != nullptr){
+        // the free space map fetches a bitmap page, allocate before latch_
+        page_id_t new_page_id = disk_manager_->AllocatePage();
+        Page *Select_page = NewPageWithId(new_page_id);
+        if(Select_page == nullptr){
+            disk_manager_->DeallocatePage(new_page_id);
+            return nullptr;
+        }
+        page_id = new_page_id;
+        return Select_page;
+    }
+    auto start = BufferPoolMetrics::clock::now();
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
+    Page *Select_page = GetVictimPage(lock);
+    if(Select_page == nullptr){
+        return nullptr;
+    }
+    page_id = disk_manager_->AllocatePage();
+    ReplaceFrame(Select_page, page_id);
+    lock.unlock();
+    LoadFrame(Select_page, false);
+    metrics_.Add(StatCounter::NEW_PAGE);
+    metrics_.Record(StatLatency::NEW_PAGE, start);
+    return Select_page;
+}
+
+/*
+ * Same as NewPage(), except that page_id has already been allocated by the
+ * caller through the disk manager. Used by ParallelBufferPoolManager, which
+ * has to know the page id before choosing the instance that holds it.
+ * return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManager::NewPageWithId(page_id_t page_id) {
+    auto start = BufferPoolMetrics::clock::now();
+    std::unique_lock<std::mutex> lock(latch_, std::defer_lock);
+    LockLatch(lock);
+    Page *Select_page = nullptr;
+    while(true){
+        DropStaleCopy(page_id, lock);
+        Select_page = GetVictimPage(lock);
+        if(Select_page == nullptr){
+            return nullptr;
+        }
+        // latch_ may have been released, check nobody brought page_id back
+        Page *resident = nullptr;
+        if(!page_table_->Find(page_id, resident) &&
+           writing_back_.find(page_id) == writing_back_.end()){
+            break;
+        }
+        if(Select_page->page_id_ == INVALID_PAGE_ID){
+            free_list_->push_front(Select_page);
+        }else{
+            Select_page->pin_count_ = 0;
+            replacer_->Insert(Select_page);
+        }
+    }
+    ReplaceFrame(Select_page, page_id);
+    lock.unlock();
+    LoadFrame(Select_page, false);
+    metrics_.Add(StatCounter::NEW_PAGE);
+    metrics_.Record(StatLatency::NEW_PAGE, start);
+    return Select_page;
+}
+
+/*
+ * Start reading each page that is neither resident nor being written back
+ * into a frame of its own. The frame goes into the page table right away,
+ * unpinned and I/O in progress: a fetcher pins it and waits for the read,
+ * nobody can evict it before the read completes. Stop at the first page no
+ * frame is available for
+ */
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids,
+                                      BufferAccessStrategy *strategy) {
+    std::vector<Page *> frames;
+    {
         std::lock_guard<std::mutex> guard(latch_);
+        Page *Select_page = nullptr;
+        for(auto page_id : page_ids){
+            if(page_id == INVALID_PAGE_ID || page_table_->Find(page_id, Select_page) ||
+               writing_back_.find(page_id) != writing_back_.end()){
+                continue;
+            }
+            Select_page = GetPrefetchFrame(strategy);
+            if(Select_page == nullptr){
+                break;
+            }
+            ReplaceFrame(Select_page, page_id, false);
+            if(strategy != nullptr){
+                AddToRing(strategy, Select_page);
+            }
+            // a prefetch is not an access, the first fetch will be
+            replacer_->Erase(Select_page);
+            ++prefetching_;
+            frames.push_back(Select_page);
+        }
+    }
+    // queued without latch_: the I/O engine may wait for completions, which
+    // take latch_
+    for(auto *Select_page : frames){
+        FinishEviction(Select_page);
+        if(ReadFromVictimCache(Select_page)){
+            FinishPrefetch(Select_page, false);
+            continue;
+        }
+        disk_manager_->ReadPageAsync(Select_page->page_id_, Select_page->GetData(),
+                                     [this, Select_page] { FinishPrefetch(Select_page, true); });
+    }
+}
+
+std::vector<page_id_t> BufferPoolManager::GetResidentPages() {
+    std::lock_guard<std::mutex> guard(latch_);
+    std::vector<page_id_t> page_ids;
+    for(auto *Select_page : pages_){
+        if(Select_page->page_id_ != INVALID_PAGE_ID &&
+           Select_page->pin_count_ > 0){
+            page_ids.push_back(Select_page->page_id_);
+        }
+    }
+    // the replacer goes from the cold end
+    std::vector<Page *> unpinned;
+    replacer_->Peek(unpinned, replacer_->Size());
+    for(auto it = unpinned.rbegin(); it != unpinned.rend(); ++it){
+        // pinned by a page table hit since, listed already
+        if((*it)->pin_count_ <= 0){
+            page_ids.push_back((*it)->page_id_);
+        }
+    }
+    return page_ids;
+}
+
+void BufferPoolManager::WarmUp(std::vector<page_id_t> page_ids) {
+    if(page_ids.size() > GetPoolSize()){
+        page_ids.resize(GetPoolSize());
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+    PrefetchPages(page_ids);
+}
+
+/*
+ * A clean frame of the strategy ring, else the free list, then the next
+ * victim of the replacer, but only if it is clean and idle: a speculative
+ * read must not cost a write or a wait
+ */
+Page *BufferPoolManager::GetPrefetchFrame(BufferAccessStrategy *strategy) {
     Page *Select_page = nullptr;
+    if(strategy != nullptr){
+        Select_page = GetRingVictim(strategy, true);
+        if(Select_page != nullptr){
+            return Select_page;
+        }
+    }
     if(!free_list_->empty()){
         Select_page = free_list_->front();
         free_list_->pop_front();
-    }else{
-        if(!replacer_->Victim(Select_page)){
-            return nullptr;
+        return Select_page;
+    }
+    std::vector<Page *> next_victim;
+    replacer_->Peek(next_victim, 1);
+    if(next_victim.empty() || next_victim[0]->is_dirty_ ||
+       next_victim[0]->io_in_progress_ || !ClaimFrame(next_victim[0])){
+        return nullptr;
+    }
+    return next_victim[0];
+}
+
+/*
+ * Once the ring is full, look for the next slot, round robin, whose page is
+ * still held by the same frame of this instance, and that frame is neither
+ * pinned nor under I/O. Take it out of the replacer and return it. The frame
+ * of a slot is only dereferenced once the page table vouches for it, it may
+ * have been retired by a shrink. Caller must hold latch_
+ */
+Page *BufferPoolManager::GetRingVictim(BufferAccessStrategy *strategy,
+                                       bool clean_only) {
+    auto &ring = strategy->ring_;
+    if(ring.size() < strategy->ring_size_){
+        return nullptr;
+    }
+    for(size_t i = 0; i < ring.size(); ++i){
+        size_t slot = (strategy->next_ + i) % ring.size();
+        Page *Select_page = nullptr;
+        if(!page_table_->Find(ring[slot].page_id, Select_page) ||
+           Select_page != ring[slot].page || Select_page->io_in_progress_ ||
+           (clean_only && Select_page->is_dirty_) || !ClaimFrame(Select_page)){
+            continue;
         }
+        strategy->next_ = slot;
+        return Select_page;
+    }
+    return nullptr;
+}
+
+/*
+ * Fill the ring up to its size, then overwrite the slot at the cursor, which
+ * is the slot GetRingVictim() just recycled, or the one it could not
+ */
+void BufferPoolManager::AddToRing(BufferAccessStrategy *strategy,
+                                  Page *Select_page) {
+    auto &ring = strategy->ring_;
+    BufferAccessStrategy::Slot slot{Select_page, Select_page->page_id_};
+    if(ring.size() < strategy->ring_size_){
+        ring.push_back(slot);
+        return;
+    }
+    ring[strategy->next_] = slot;
+    strategy->next_ = (strategy->next_ + 1) % ring.size();
+}
+
+/*
+ * The read is done: wake up the fetchers waiting for it, and if nobody pinned
+ * the frame meanwhile make it evictable
+ */
+void BufferPoolManager::FinishPrefetch(Page *Select_page, bool from_disk) {
+    metrics_.Add(StatCounter::PREFETCH);
+    if(from_disk){
+        metrics_.Add(StatCounter::DISK_READ);
+    }
+    std::lock_guard<std::mutex> guard(latch_);
+    Select_page->io_in_progress_ = false;
+    Select_page->io_cv_.notify_all();
+    if(Select_page->pin_count_ == 0){
+        replacer_->Insert(Select_page);
+    }
+    --prefetching_;
+    prefetch_cv_.notify_all();
+}
+
+/*
+ * Grow first: the new frames go to the free list and are usable right away.
+ * Shrink in rounds, a round may release latch_ to write dirty frames back,
+ * until the target is met or a round finds nothing left to take
+ */
+bool BufferPoolManager::ResizePool(size_t pool_size) {
+    std::unique_lock<std::mutex> lock(latch_);
+    while(pool_size_ < pool_size){
+        Page *Select_page = NewFrame();
+        pages_.push_back(Select_page);
+        free_list_->push_back(Select_page);
+        ++pool_size_;
+    }
+    while(pool_size_ > pool_size){
+        if(!ShrinkPool(pool_size, lock)){
+            return false;
+        }
+    }
+    return true;
+}
+
+Page *BufferPoolManager::NewFrame() {
+    if(retired_.empty()){
+        return new Page(frame_slab_->Allocate());
+    }
+    Page *Select_page = retired_.back();
+    retired_.pop_back();
+    Select_page->data_ = frame_slab_->Allocate();
+    Select_page->ResetMemory();
+    return Select_page;
+}
+
+/*
+ * One shrink round: free frames are retired at once. Then the coldest
+ * unpinned, idle frames leave the page table and the replacer; clean ones
+ * are retired, dirty ones are marked I/O in progress and written back without
+ * latch_. A dirty frame somebody pinned during its write (the fetcher waits
+ * for the write) stays in the pool, it goes back to the replacer on unpin
+ */
+bool BufferPoolManager::ShrinkPool(size_t pool_size,
+                                   std::unique_lock<std::mutex> &lock) {
+    size_t excess = pool_size_ - pool_size;
+    std::vector<Page *> frames;
+    while(!free_list_->empty() && frames.size() < excess){
+        frames.push_back(free_list_->front());
+        free_list_->pop_front();
+    }
+    std::vector<Page *> cold_pages;
+    std::vector<Page *> dirty_pages;
+    if(frames.size() < excess){
+        replacer_->Peek(cold_pages, replacer_->Size());
+    }
+    for(auto *Select_page : cold_pages){
+        if(frames.size() + dirty_pages.size() >= excess){
+            break;
+        }
+        if(Select_page->io_in_progress_ || Select_page->pin_count_ > 0){
+            continue;
+        }
+        if(Select_page->is_dirty_){
+            replacer_->Erase(Select_page);
+            Select_page->is_dirty_ = false;
+            Select_page->io_in_progress_ = true;
+            dirty_pages.push_back(Select_page);
+        }else if(ClaimFrame(Select_page)){
+            page_table_->Remove(Select_page->page_id_);
+            frames.push_back(Select_page);
+        }
+    }
+    RetireFrames(frames);
+    if(dirty_pages.empty()){
+        return !frames.empty();
+    }
+    lock.unlock();
+    for(auto *Select_page : dirty_pages){
+        WriteToDisk(Select_page->page_id_, Select_page->GetData());
+    }
+    lock.lock();
+    frames.clear();
+    for(auto *Select_page : dirty_pages){
+        Select_page->io_in_progress_ = false;
+        Select_page->io_cv_.notify_all();
+        if(ClaimFrame(Select_page)){
+            page_table_->Remove(Select_page->page_id_);
+            frames.push_back(Select_page);
+        }
+    }
+    RetireFrames(frames);
+    return true;
+}
+
+/*
+ * Frames are no longer in the page table, the replacer or the free list. Free
+ * their data and move them from pages_ to retired_
+ */
+void BufferPoolManager::RetireFrames(const std::vector<Page *> &frames) {
+    if(frames.empty()){
+        return;
+    }
+    for(auto *Select_page : frames){
+        // compressed under latch_, shrinking is rare
+        if(Select_page->page_id_ != INVALID_PAGE_ID){
+            ToVictimCache(Select_page, Select_page->page_id_);
+        }
+        InvalidateFrame(Select_page);
+        Select_page->Unswizzle();
+        Select_page->page_id_ = INVALID_PAGE_ID;
+    }
+    // optimistic readers may still be reading the frames they found before
+    // the frames left the page table. They never block, so waiting for them
+    // under latch_ is short
+    EpochManager::Synchronize();
+    for(auto *Select_page : frames){
+        frame_slab_->Free(Select_page->data_);
+        Select_page->data_ = nullptr;
+        retired_.push_back(Select_page);
+    }
+    pages_.erase(std::remove_if(pages_.begin(), pages_.end(),
+                                [](Page *page) { return page->data_ == nullptr; }),
+                 pages_.end());
+    pool_size_ -= frames.size();
+}
+
+/*
+ * Pick a frame for a new page, always from free list first, then from lru
+ * replacer. A victim the page cleaner is still writing back is waited for,
+ * releasing latch_ meanwhile, unless it gets pinned again during the wait.
+ * A dirty victim means the page cleaner is behind, wake it up. With no
+ * victim, in-flight prefetches are waited for.
+ * Caller must hold latch_ through lock
+ * return nullptr if all the pages in pool are pinned
+ */
+Page *BufferPoolManager::GetVictimPage(std::unique_lock<std::mutex> &lock) {
+    Page *Select_page = nullptr;
+    if(!free_list_->empty()){
+        Select_page = free_list_->front();
+        free_list_->pop_front();
+        return Select_page;
+    }
+    metrics_.Add(StatCounter::FREE_LIST_EMPTY);
+    std::vector<Page *> next_victim;
+    while(true){
+        next_victim.clear();
+        replacer_->Peek(next_victim, 1);
+        if(!next_victim.empty()){
+            Select_page = next_victim[0];
+            if(Select_page->io_in_progress_){
+                // pinned, deleted or evicted by another thread during the
+                // wait, or still the next victim
+                WaitForIO(Select_page, lock);
+                continue;
+            }
+            // pinned by a page table hit, no longer a victim
+            if(!ClaimFrame(Select_page)){
+                continue;
+            }
+            if(Select_page->is_dirty_ && cleaner_running_){
+                cleaner_cv_.notify_one();
+            }
+            return Select_page;
+        }
+        // prefetched frames enter the replacer once read, as after a warm-up
+        // that filled the whole pool
+        if(prefetching_ == 0){
+            break;
+        }
+        prefetch_cv_.wait(lock);
+        if(!free_list_->empty()){
+            Select_page = free_list_->front();
+            free_list_->pop_front();
+            return Select_page;
+        }
+    }
+    metrics_.Add(StatCounter::NO_FREE_FRAME);
+    return nullptr;
+}
+
+/*
+ * A deleted page can be read back into the pool, by a prefetch or an
+ * optimistic reader that found its id before it was deleted, until the id is
+ * allocated again. Drop that copy: wait for its I/O, then for its users, who
+ * let go once they find out the page is gone, so that the new page is the
+ * only frame of page_id. A write back of the copy is waited for as well, it
+ * must not land over the new page
+ */
+void BufferPoolManager::DropStaleCopy(page_id_t page_id,
+                                      std::unique_lock<std::mutex> &lock) {
+    while(true){
+        Page *Select_page = nullptr;
+        if(page_table_->Find(page_id, Select_page)){
+            if(Select_page->io_in_progress_){
+                Select_page->io_cv_.wait(lock);
+                continue;
+            }
+            if(!ClaimFrame(Select_page)){
+                lock.unlock();
+                std::this_thread::yield();
+                lock.lock();
+                continue;
+            }
+            FreeFrame(Select_page);
+            continue;
+        }
+        auto writing = writing_back_.find(page_id);
+        if(writing != writing_back_.end()){
+            Page *frame = writing->second;
+            frame->io_cv_.wait(lock, [&] { return frame->evicted_page_id_ != page_id; });
+            continue;
+        }
+        return;
+    }
+}
+
+/*
+ * Reuse the victim frame for page_id: move the page table entry, pin the frame
+ * for the caller and mark it I/O in progress, so that other fetchers of
+ * page_id wait on this frame instead of reading the page a second time. If
+ * the old content is dirty, remember it as being written back. The frame is
+ * marked I/O in progress before it is pinned: a latch free fetcher that pins
+ * it must see the read pending.
+ * Caller must hold latch_ and call LoadFrame() once the latch is released
+ */
+void BufferPoolManager::ReplaceFrame(Page *Select_page, page_id_t page_id,
+                                     bool pin) {
+    if(Select_page->page_id_ != INVALID_PAGE_ID){
+        metrics_.Add(StatCounter::EVICTION);
     }
-    page_id = disk_manager_->AllocatePage();
     if(Select_page->is_dirty_){
-        disk_manager_->WritePage(Select_page->page_id_, Select_page->GetData());
+        metrics_.Add(StatCounter::DIRTY_EVICTION);
     }
+    // with a victim cache, a clean page is held back too until its copy is in
+    if(Select_page->is_dirty_ || (Select_page->page_id_ != INVALID_PAGE_ID &&
+                                  victim_cache_.load() != nullptr)){
+        Select_page->evicted_page_id_ = Select_page->page_id_;
+        Select_page->evicted_dirty_ = Select_page->is_dirty_;
+        writing_back_[Select_page->page_id_] = Select_page;
+    }
+    Select_page->io_in_progress_ = true;
+    InvalidateFrame(Select_page);
+    Select_page->Unswizzle();
     page_table_->Remove(Select_page->page_id_);
-    page_table_->Insert(page_id, Select_page);
     Select_page->page_id_ = page_id;
+    // callers checked page_id has no frame yet
+    bool inserted = page_table_->Insert(page_id, Select_page);
+    assert(inserted);
+    (void)inserted;
     Select_page->is_dirty_ = false;
-    Select_page->pin_count_ = 1;
-    Select_page->ResetMemory();
-    return Select_page;
+    Select_page->hits_ = 0;
+    // the frame was claimed, latch free fetchers may pin it from now on
+    Select_page->pin_count_ = pin ? 1 : 0;
+    replacer_->Pin(Select_page);
+}
+
+/*
+ * Pin a resident frame with a compare and swap, unpinned or not: a frame is
+ * only replaced or freed once claimed, with a pin count of -1, which a pin
+ * cannot get past. An unpinned frame stays in the replacer, whoever picks it
+ * there finds it pinned and leaves it, see ClaimFrame(). The page table lookup
+ * was done without latch_ too, so check the frame still holds page_id and is
+ * loaded once pinned. The hit is counted in the frame, the replacer gets the
+ * count on the last unpin
+ */
+bool BufferPoolManager::TryPinResident(Page *Select_page, page_id_t page_id) {
+    int pin_count = Select_page->pin_count_.load();
+    do{
+        if(pin_count < 0){
+            return false;
+        }
+    }while(!Select_page->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+    if(Select_page->page_id_ == page_id && !Select_page->io_in_progress_){
+        Select_page->hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    // raced with a replacement, hand the pin back, it may be the last one
+    std::unique_lock<std::mutex> lock(latch_);
+    page_id_t pinned_page_id = Select_page->page_id_;
+    if(--Select_page->pin_count_ == 0 && ReleaseFrame(Select_page, lock)){
+        lock.unlock();
+        disk_manager_->DeallocatePage(pinned_page_id);
+    }
+    return false;
+}
+
+/*
+ * Fail the optimistic reads of the current content: bump the latch version.
+ * The frame is unpinned, so nobody holds its latch for long, if at all
+ */
+void BufferPoolManager::InvalidateFrame(Page *Select_page) {
+    Select_page->WLatch();
+    Select_page->WUnlatch();
+}
+
+/*
+ * Second half of a frame replacement, done without holding latch_: the frame
+ * is pinned and I/O in progress, so nobody else touches its content. Write the
+ * evicted page back if needed and keep it in the victim cache, then read page
+ * content from the victim cache or the disk file (or zero it out for a new
+ * page) and wake up the threads waiting on this frame. Fetchers of the evicted
+ * page wait until it is cached, so an old copy never lands over a newer one
+ */
+void BufferPoolManager::LoadFrame(Page *Select_page, bool read_from_disk) {
+    FinishEviction(Select_page);
+    if(read_from_disk){
+        if(!ReadFromVictimCache(Select_page)){
+            ReadFromDisk(Select_page->page_id_, Select_page->GetData());
+        }
+    }else{
+        Select_page->ResetMemory();
+        // a page id handed out again must not find what an old page left
+        CompressedPageCache *victim_cache = victim_cache_.load();
+        if(victim_cache != nullptr){
+            victim_cache->Erase(Select_page->page_id_);
+        }
+    }
+    std::lock_guard<std::mutex> guard(latch_);
+    Select_page->io_in_progress_ = false;
+    Select_page->io_cv_.notify_all();
+}
+
+/*
+ * The frame is pinned or I/O in progress: write the page it held back if it
+ * was dirty, hand it to the victim cache, then let its fetchers in
+ */
+void BufferPoolManager::FinishEviction(Page *Select_page) {
+    page_id_t evicted_page_id = Select_page->evicted_page_id_;
+    if(evicted_page_id == INVALID_PAGE_ID){
+        return;
+    }
+    if(Select_page->evicted_dirty_){
+        WriteToDisk(evicted_page_id, Select_page->GetData());
+    }
+    ToVictimCache(Select_page, evicted_page_id);
+    std::lock_guard<std::mutex> guard(latch_);
+    writing_back_.erase(evicted_page_id);
+    Select_page->evicted_page_id_ = INVALID_PAGE_ID;
+    Select_page->io_cv_.notify_all();
+}
+
+bool BufferPoolManager::ReadFromVictimCache(Page *Select_page) {
+    CompressedPageCache *victim_cache = victim_cache_.load();
+    if(victim_cache == nullptr){
+        return false;
+    }
+    if(victim_cache->Take(Select_page->page_id_, Select_page->GetData())){
+        metrics_.Add(StatCounter::VICTIM_CACHE_HIT);
+        return true;
+    }
+    metrics_.Add(StatCounter::VICTIM_CACHE_MISS);
+    return false;
+}
+
+void BufferPoolManager::ToVictimCache(Page *Select_page, page_id_t page_id) {
+    CompressedPageCache *victim_cache = victim_cache_.load();
+    if(victim_cache != nullptr){
+        victim_cache->Insert(page_id, Select_page->GetData());
+    }
+}
+
+/*
+ * Turning the cache on creates it, later calls only change its capacity, so
+ * threads loading frames never see it go away
+ */
+void BufferPoolManager::EnableVictimCache(size_t capacity) {
+    std::lock_guard<std::mutex> guard(latch_);
+    CompressedPageCache *victim_cache = victim_cache_.load();
+    if(victim_cache == nullptr){
+        if(capacity == 0){
+            return;
+        }
+        victim_cache_.store(new CompressedPageCache(capacity));
+        return;
+    }
+    victim_cache->SetCapacity(capacity);
+}
+
+size_t BufferPoolManager::GetVictimCacheSize() {
+    CompressedPageCache *victim_cache = victim_cache_.load();
+    return victim_cache == nullptr ? 0 : victim_cache->GetSize();
+}
+
+void BufferPoolManager::EnableFreeSpaceMap() {
+    if(free_space_map_ == nullptr){
+        free_space_map_ = new FreeSpaceMap(this);
+        disk_manager_->SetFreeSpaceMap(free_space_map_);
+    }
+}
+
+size_t BufferPoolManager::GetMemoryUsage() {
+    std::lock_guard<std::mutex> guard(latch_);
+    return frame_slab_->GetReservedBytes() + GetVictimCacheSize();
+}
+
+/*
+ * Wait until the frame holding page is loaded. The caller must have pinned
+ * page, so the frame cannot be handed to another page meanwhile
+ */
+void BufferPoolManager::WaitForIO(Page *Select_page,
+                                  std::unique_lock<std::mutex> &lock) {
+    Select_page->io_cv_.wait(lock, [&] { return !Select_page->io_in_progress_; });
+}
+
+/*
+ * An uncontended latch costs a try_lock, the clock is only read when the
+ * caller has to wait
+ */
+void BufferPoolManager::LockLatch(std::unique_lock<std::mutex> &lock) {
+    if(lock.try_lock()){
+        return;
+    }
+    auto start = BufferPoolMetrics::clock::now();
+    lock.lock();
+    metrics_.Add(StatCounter::LATCH_WAIT);
+    metrics_.Add(StatCounter::LATCH_WAIT_NS, static_cast<uint64_t>(
+                 std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     BufferPoolMetrics::clock::now() - start).count()));
+}
+
+void BufferPoolManager::ReadFromDisk(page_id_t page_id, char *data) {
+    auto start = BufferPoolMetrics::clock::now();
+    disk_manager_->ReadPage(page_id, data);
+    metrics_.Add(StatCounter::DISK_READ);
+    metrics_.Record(StatLatency::DISK_READ, start);
+}
+
+void BufferPoolManager::WriteToDisk(page_id_t page_id, const char *data) {
+    auto start = BufferPoolMetrics::clock::now();
+    disk_manager_->WritePage(page_id, data);
+    metrics_.Add(StatCounter::DISK_WRITE);
+    metrics_.Record(StatLatency::DISK_WRITE, start);
+}
+/*
+ * Start the page cleaner. It wakes up every PAGE_CLEANER_TIMEOUT, or earlier
+ * when a foreground thread had to evict a dirty frame
+ */
+void BufferPoolManager::RunCleanerThread(double dirty_ratio) {
+    std::lock_guard<std::mutex> guard(latch_);
+    if(cleaner_running_){
+        return;
+    }
+    dirty_ratio_ = dirty_ratio;
+    cleaner_running_ = true;
+    cleaner_thread_ = new std::thread(&BufferPoolManager::CleanerLoop, this);
+}
+
+/*
+ * Stop and join the page cleaner, frames it is writing are done on return
+ */
+void BufferPoolManager::StopCleanerThread() {
+    {
+        std::lock_guard<std::mutex> guard(latch_);
+        if(!cleaner_running_){
+            return;
+        }
+        cleaner_running_ = false;
+        cleaner_cv_.notify_one();
+    }
+    cleaner_thread_->join();
+    delete cleaner_thread_;
+    cleaner_thread_ = nullptr;
+}
+
+void BufferPoolManager::CleanerLoop() {
+    std::unique_lock<std::mutex> lock(latch_);
+    while(cleaner_running_){
+        cleaner_cv_.wait_for(lock, PAGE_CLEANER_TIMEOUT);
+        if(cleaner_running_){
+            CleanColdPages(lock);
+        }
+    }
+}
+
+/*
+ * If more than dirty_ratio_ of the pool is dirty, walk the replacer from the
+ * next victim on and write back dirty frames until the ratio is met, so the
+ * frames about to be evicted are clean. The frames stay where they are in the
+ * replacer; they are marked I/O in progress and written without latch_, a
+ * thread fetching or evicting one of them meanwhile waits on the frame.
+ * Caller must hold latch_ through lock
+ */
+void BufferPoolManager::CleanColdPages(std::unique_lock<std::mutex> &lock) {
+    size_t dirty_count = 0;
+    for(auto *Select_page : pages_){
+        if(Select_page->is_dirty_){
+            ++dirty_count;
+        }
+    }
+    size_t watermark = static_cast<size_t>(dirty_ratio_ * pool_size_);
+    if(dirty_count <= watermark){
+        return;
+    }
+    std::vector<Page *> cold_pages;
+    replacer_->Peek(cold_pages, replacer_->Size());
+    std::vector<Page *> batch;
+    for(auto *Select_page : cold_pages){
+        if(dirty_count <= watermark){
+            break;
+        }
+        // pinned by a page table hit, maybe being written to
+        if(!Select_page->is_dirty_ || Select_page->io_in_progress_ ||
+           Select_page->pin_count_ > 0){
+            continue;
+        }
+        Select_page->is_dirty_ = false;
+        Select_page->io_in_progress_ = true;
+        batch.push_back(Select_page);
+        --dirty_count;
+    }
+    if(batch.empty()){
+        return;
+    }
+    lock.unlock();
+    for(auto *Select_page : batch){
+        WriteToDisk(Select_page->page_id_, Select_page->GetData());
+    }
+    lock.lock();
+    for(auto *Select_page : batch){
+        Select_page->io_in_progress_ = false;
+        Select_page->io_cv_.notify_all();
+    }
 }
 } // namespace scudb
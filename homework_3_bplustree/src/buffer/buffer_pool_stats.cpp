@@ -0,0 +1,119 @@
+/**
+ * buffer_pool_stats.cpp
+ */
+
+#include "buffer/buffer_pool_stats.h"
+
+namespace scudb {
+
+static const char *COUNTER_NAMES[] = {
+    "fetch_hit",       "fetch_miss",    "new_page",   "unpin",
+    "eviction",        "dirty_eviction", "free_list_empty",
+    "no_free_frame",   "prefetch",      "disk_read",  "disk_write",
+    "latch_wait",      "latch_wait_ns", "victim_cache_hit",
+    "victim_cache_miss"};
+
+static const char *LATENCY_NAMES[] = {"fetch_page", "new_page", "unpin_page",
+                                      "disk_read", "disk_write"};
+
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) ==
+                  static_cast<size_t>(StatCounter::NUM_COUNTERS),
+              "a counter has no name");
+static_assert(sizeof(LATENCY_NAMES) / sizeof(LATENCY_NAMES[0]) ==
+                  static_cast<size_t>(StatLatency::NUM_LATENCIES),
+              "a latency has no name");
+
+double LatencyHistogram::MeanNs() const {
+  return count == 0 ? 0 : static_cast<double>(total_ns) / count;
+}
+
+uint64_t LatencyHistogram::PercentileNs(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(p * count);
+  if (rank >= count) {
+    rank = count - 1;
+  }
+  uint64_t seen = 0;
+  for (int i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      return (uint64_t(1) << (i + 1)) - 1;
+    }
+  }
+  return (uint64_t(1) << STATS_HISTOGRAM_BUCKETS) - 1;
+}
+
+double BufferPoolStats::HitRatio() const {
+  uint64_t fetches = Get(StatCounter::FETCH_HIT) + Get(StatCounter::FETCH_MISS);
+  return fetches == 0
+             ? 0
+             : static_cast<double>(Get(StatCounter::FETCH_HIT)) / fetches;
+}
+
+BufferPoolStats &BufferPoolStats::operator+=(const BufferPoolStats &that) {
+  for (int i = 0; i < static_cast<int>(StatCounter::NUM_COUNTERS); ++i) {
+    counters[i] += that.counters[i];
+  }
+  for (int i = 0; i < static_cast<int>(StatLatency::NUM_LATENCIES); ++i) {
+    latencies[i].count += that.latencies[i].count;
+    latencies[i].total_ns += that.latencies[i].total_ns;
+    for (int j = 0; j < STATS_HISTOGRAM_BUCKETS; ++j) {
+      latencies[i].buckets[j] += that.latencies[i].buckets[j];
+    }
+  }
+  return *this;
+}
+
+const char *BufferPoolStats::GetName(StatCounter counter) {
+  return COUNTER_NAMES[static_cast<int>(counter)];
+}
+
+const char *BufferPoolStats::GetName(StatLatency latency) {
+  return LATENCY_NAMES[static_cast<int>(latency)];
+}
+
+void BufferPoolMetrics::Record(StatLatency latency, uint64_t ns) {
+  Histogram &histogram = GetShard().latencies[static_cast<int>(latency)];
+  // floor(log2(ns)), 0 and 1 ns both go to the first bucket
+  int bucket = 63 - __builtin_clzll(ns | 1);
+  if (bucket >= STATS_HISTOGRAM_BUCKETS) {
+    bucket = STATS_HISTOGRAM_BUCKETS - 1;
+  }
+  histogram.count.fetch_add(1, std::memory_order_relaxed);
+  histogram.total_ns.fetch_add(ns, std::memory_order_relaxed);
+  histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+/*
+ * Threads are numbered on their first update of any pool, and the number picks
+ * the shard, so up to STATS_SHARD_NUM threads never share one
+ */
+BufferPoolMetrics::Shard &BufferPoolMetrics::GetShard() {
+  static std::atomic<size_t> next_thread_slot{0};
+  thread_local size_t thread_slot = next_thread_slot.fetch_add(1);
+  return shards_[thread_slot % STATS_SHARD_NUM];
+}
+
+BufferPoolStats BufferPoolMetrics::GetStats() const {
+  BufferPoolStats stats;
+  for (const auto &shard : shards_) {
+    for (int i = 0; i < static_cast<int>(StatCounter::NUM_COUNTERS); ++i) {
+      stats.counters[i] += shard.counters[i].load(std::memory_order_relaxed);
+    }
+    for (int i = 0; i < static_cast<int>(StatLatency::NUM_LATENCIES); ++i) {
+      const Histogram &histogram = shard.latencies[i];
+      LatencyHistogram &latency = stats.latencies[i];
+      latency.count += histogram.count.load(std::memory_order_relaxed);
+      latency.total_ns += histogram.total_ns.load(std::memory_order_relaxed);
+      for (int j = 0; j < STATS_HISTOGRAM_BUCKETS; ++j) {
+        latency.buckets[j] +=
+            histogram.buckets[j].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return stats;
+}
+
+} // namespace scudb
@@ -0,0 +1,195 @@
+/**
+ * compressed_page_cache.cpp
+ */
+
+#include <cstring>
+#include <vector>
+
+#include "buffer/compressed_page_cache.h"
+
+namespace scudb {
+
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+#define LZ_MAX_LITERAL 0x80
+#define LZ_MAX_OFFSET 0xffff
+#define LZ_HASH_BITS 12
+
+CompressedPageCache::CompressedPageCache(size_t capacity)
+    : capacity_(capacity) {}
+
+/*
+ * The new copy is compressed before latch_ is taken. It goes to the front of
+ * the list, the copies evicted longest ago are dropped from the back to make
+ * room
+ */
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  std::vector<char> buffer(PAGE_SIZE);
+  size_t size = Compress(data, PAGE_SIZE, buffer.data(), PAGE_SIZE - 1);
+  std::lock_guard<std::mutex> guard(latch_);
+  auto found = index_.find(page_id);
+  if (found != index_.end()) {
+    Remove(found->second);
+  }
+  if (size == 0 || size > capacity_) {
+    return;
+  }
+  while (size_ + size > capacity_) {
+    Remove(std::prev(entries_.end()));
+  }
+  entries_.push_front(Entry{page_id, std::string(buffer.data(), size)});
+  index_[page_id] = entries_.begin();
+  size_ += size;
+}
+
+bool CompressedPageCache::Take(page_id_t page_id, char *data) {
+  std::string compressed;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto found = index_.find(page_id);
+    if (found == index_.end()) {
+      return false;
+    }
+    compressed = found->second->data;
+    Remove(found->second);
+  }
+  return Decompress(compressed.data(), compressed.size(), data, PAGE_SIZE);
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto found = index_.find(page_id);
+  if (found != index_.end()) {
+    Remove(found->second);
+  }
+}
+
+void CompressedPageCache::SetCapacity(size_t capacity) {
+  std::lock_guard<std::mutex> guard(latch_);
+  capacity_ = capacity;
+  while (size_ > capacity_) {
+    Remove(std::prev(entries_.end()));
+  }
+}
+
+size_t CompressedPageCache::GetCapacity() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return capacity_;
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return index_.size();
+}
+
+void CompressedPageCache::Remove(std::list<Entry>::iterator it) {
+  size_ -= it->data.size();
+  index_.erase(it->page_id);
+  entries_.erase(it);
+}
+
+static inline uint32_t HashBytes(const char *bytes) {
+  uint32_t value = static_cast<uint8_t>(bytes[0]) |
+                   static_cast<uint8_t>(bytes[1]) << 8 |
+                   static_cast<uint8_t>(bytes[2]) << 16;
+  return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/*
+ * Greedy parse: at each position, the last position with the same 3 bytes is
+ * the only match candidate
+ */
+size_t CompressedPageCache::Compress(const char *src, size_t size, char *dst,
+                                     size_t capacity) {
+  std::vector<int> last_seen(1 << LZ_HASH_BITS, -1);
+  size_t out = 0;
+  size_t literal_start = 0;
+  // emit src[literal_start, end) as literal runs
+  auto flush_literals = [&](size_t end) {
+    while (literal_start < end) {
+      size_t run = end - literal_start;
+      if (run > LZ_MAX_LITERAL) {
+        run = LZ_MAX_LITERAL;
+      }
+      if (out + 1 + run > capacity) {
+        return false;
+      }
+      dst[out++] = static_cast<char>(run - 1);
+      memcpy(dst + out, src + literal_start, run);
+      out += run;
+      literal_start += run;
+    }
+    return true;
+  };
+
+  size_t in = 0;
+  while (in + LZ_MIN_MATCH <= size) {
+    uint32_t hash = HashBytes(src + in);
+    int candidate = last_seen[hash];
+    last_seen[hash] = static_cast<int>(in);
+    if (candidate < 0 || in - candidate > LZ_MAX_OFFSET ||
+        memcmp(src + candidate, src + in, LZ_MIN_MATCH) != 0) {
+      ++in;
+      continue;
+    }
+    size_t length = LZ_MIN_MATCH;
+    while (in + length < size && length < LZ_MAX_MATCH &&
+           src[candidate + length] == src[in + length]) {
+      ++length;
+    }
+    if (!flush_literals(in) || out + 3 > capacity) {
+      return 0;
+    }
+    size_t offset = in - candidate;
+    dst[out++] = static_cast<char>(0x80 | (length - LZ_MIN_MATCH));
+    dst[out++] = static_cast<char>(offset & 0xff);
+    dst[out++] = static_cast<char>(offset >> 8);
+    in += length;
+    literal_start = in;
+  }
+  if (!flush_literals(size)) {
+    return 0;
+  }
+  return out;
+}
+
+bool CompressedPageCache::Decompress(const char *src, size_t src_size,
+                                     char *dst, size_t size) {
+  size_t in = 0;
+  size_t out = 0;
+  while (in < src_size) {
+    uint8_t token = static_cast<uint8_t>(src[in++]);
+    if (token < 0x80) {
+      size_t run = token + 1;
+      if (in + run > src_size || out + run > size) {
+        return false;
+      }
+      memcpy(dst + out, src + in, run);
+      in += run;
+      out += run;
+      continue;
+    }
+    if (in + 2 > src_size) {
+      return false;
+    }
+    size_t length = (token & 0x7f) + LZ_MIN_MATCH;
+    size_t offset = static_cast<uint8_t>(src[in]) |
+                    static_cast<uint8_t>(src[in + 1]) << 8;
+    in += 2;
+    if (offset == 0 || offset > out || out + length > size) {
+      return false;
+    }
+    // byte by byte, a match may overlap what it produces
+    for (size_t i = 0; i < length; ++i, ++out) {
+      dst[out] = dst[out - offset];
+    }
+  }
+  return out == size;
+}
+
+} // namespace scudb
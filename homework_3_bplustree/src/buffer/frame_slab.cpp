@@ -0,0 +1,77 @@
+/**
+ * frame_slab.cpp
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include "buffer/frame_slab.h"
+
+namespace scudb {
+
+FrameSlab::FrameSlab(size_t frame_size, bool huge_pages)
+    : frame_size_(frame_size), huge_pages_(huge_pages) {}
+
+FrameSlab::~FrameSlab() {
+  for (auto &chunk : chunks_) {
+    munmap(chunk.base, chunk.size);
+  }
+}
+
+char *FrameSlab::Allocate() {
+  if (free_frames_.empty()) {
+    Grow();
+  }
+  char *frame = free_frames_.back();
+  free_frames_.pop_back();
+  return frame;
+}
+
+void FrameSlab::Free(char *frame) { free_frames_.push_back(frame); }
+
+/*
+ * mmap returns memory aligned on the system page size, a chunk is a multiple
+ * of both that and the frame size, so the frames of a chunk keep their
+ * alignment. Frames are handed out from the start of the chunk
+ */
+void FrameSlab::Grow() {
+  size_t system_page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t size;
+  if (huge_pages_) {
+    size = FRAME_SLAB_CHUNK_SIZE;
+  } else {
+    size = std::min(std::max(reserved_bytes_, frame_size_),
+                    static_cast<size_t>(FRAME_SLAB_CHUNK_SIZE));
+  }
+  size = std::max(size, std::max(frame_size_, system_page_size));
+  void *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (huge_pages_) {
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+#endif
+  if (base == MAP_FAILED) {
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge_pages_) {
+      madvise(base, size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+  chunks_.push_back(Chunk{static_cast<char *>(base), size});
+  reserved_bytes_ += size;
+  // the first frame ends on top, frames are handed out in address order
+  for (size_t offset = size; offset >= frame_size_; offset -= frame_size_) {
+    free_frames_.push_back(static_cast<char *>(base) + offset - frame_size_);
+  }
+}
+
+} // namespace scudb
@@ -0,0 +1,149 @@
+/**
+ * LRU-K implementation
+ */
+#include <algorithm>
+
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace scudb {
+
+template <typename T>
+LRUKReplacer<T>::LRUKReplacer(size_t k) : k_(k == 0 ? 1 : k) {}
+
+template <typename T>
+LRUKReplacer<T>::~LRUKReplacer() {}
+
+/*
+ * Mark value as evictable. A value the replacer has never seen before gets
+ * its first access recorded here.
+ */
+template <typename T>
+void LRUKReplacer<T>::Insert(const T &value) {
+  auto iter = entries_.find(value);
+  if (iter == entries_.end()) {
+    iter = entries_.emplace(value, Entry()).first;
+    RecordAccess(iter->second);
+  } else if (iter->second.evictable_) {
+    Unlink(value, iter->second);
+    RecordAccess(iter->second);
+  }
+  iter->second.evictable_ = true;
+  Link(value, iter->second);
+}
+
+/*
+ * Evict the value with the largest backward k-distance, values with infinite
+ * distance first. History of the victim is dropped.
+ */
+template <typename T>
+bool LRUKReplacer<T>::Victim(T &value) {
+  std::set<rank_t> &from = infinite_.empty() ? finite_ : infinite_;
+  if (from.empty())
+    return false;
+  value = from.begin()->second;
+  from.erase(from.begin());
+  entries_.erase(value);
+  return true;
+}
+
+/*
+ * Forget value and its history. Return true if value was evictable.
+ */
+template <typename T>
+bool LRUKReplacer<T>::Erase(const T &value) {
+  auto iter = entries_.find(value);
+  if (iter == entries_.end())
+    return false;
+  bool evictable = iter->second.evictable_;
+  if (evictable)
+    Unlink(value, iter->second);
+  entries_.erase(iter);
+  return evictable;
+}
+
+template <typename T>
+size_t LRUKReplacer<T>::Size() {
+  return infinite_.size() + finite_.size();
+}
+
+/*
+ * Record an access and make value non-evictable, keeping its history.
+ * Return true if value was evictable before.
+ */
+template <typename T>
+bool LRUKReplacer<T>::Pin(const T &value) {
+  auto iter = entries_.find(value);
+  if (iter == entries_.end()) {
+    iter = entries_.emplace(value, Entry()).first;
+  }
+  bool evictable = iter->second.evictable_;
+  if (evictable)
+    Unlink(value, iter->second);
+  iter->second.evictable_ = false;
+  RecordAccess(iter->second);
+  return evictable;
+}
+
+/*
+ * Same as count calls to Pin, only the last k_ of them can count. A count of 0
+ * only makes a known value non-evictable.
+ */
+template <typename T>
+void LRUKReplacer<T>::PinHits(const T &value, size_t count) {
+  auto iter = entries_.find(value);
+  if (iter == entries_.end()) {
+    if (count == 0)
+      return;
+    iter = entries_.emplace(value, Entry()).first;
+  } else if (iter->second.evictable_) {
+    Unlink(value, iter->second);
+  }
+  iter->second.evictable_ = false;
+  for (size_t i = 0; i < std::min(count, k_); ++i) {
+    RecordAccess(iter->second);
+  }
+}
+
+/*
+ * Victims come from the infinite distance set first, each set is already in
+ * eviction order
+ */
+template <typename T>
+void LRUKReplacer<T>::Peek(std::vector<T> &values, size_t max_count) {
+  for (auto *from : {&infinite_, &finite_}) {
+    for (auto iter = from->begin(); iter != from->end() && max_count > 0;
+         ++iter, --max_count) {
+      values.push_back(iter->second);
+    }
+  }
+}
+
+template <typename T>
+void LRUKReplacer<T>::RecordAccess(Entry &entry) {
+  entry.history_.push_back(current_timestamp_++);
+  if (entry.history_.size() > k_)
+    entry.history_.pop_front();
+}
+
+template <typename T>
+void LRUKReplacer<T>::Unlink(const T &value, const Entry &entry) {
+  if (entry.history_.size() < k_)
+    infinite_.erase(rank_t(entry.history_.front(), value));
+  else
+    finite_.erase(rank_t(entry.history_.front(), value));
+}
+
+template <typename T>
+void LRUKReplacer<T>::Link(const T &value, const Entry &entry) {
+  if (entry.history_.size() < k_)
+    infinite_.emplace(entry.history_.front(), value);
+  else
+    finite_.emplace(entry.history_.front(), value);
+}
+
+template class LRUKReplacer<Page *>;
+// test only
+template class LRUKReplacer<int>;
+
+} // namespace scudb
@@ -6,72 +6,68 @@
 
 namespace scudb {
 
-template <typename T> 
-LRUReplacer<T>::LRUReplacer() {
-  this->size = 0;
-}
+template <typename T>
+LRUReplacer<T>::LRUReplacer() {}
 
-template <typename T> 
-LRUReplacer<T>::~LRUReplacer() {
-  lru_map.clear();
-}
+template <typename T>
+LRUReplacer<T>::~LRUReplacer() {}
 
 /*
  * Insert value into LRU
+ * If value is already tracked, move it to the most recently used position
  */
-template <typename T> 
+template <typename T>
 void LRUReplacer<T>::Insert(const T &value) {
-  if(lru_map.find(value) == lru_map.end()){
-    lru_map.insert(make_pair(value, 0));
-    size++;
-  }
-  else 
-    lru_map[value] = 0;
-  for(iter = lru_map.begin(); iter != lru_map.end(); iter++){
-    (iter->second)++;
+  auto iter = lru_map_.find(value);
+  if (iter != lru_map_.end()) {
+    lru_list_.splice(lru_list_.begin(), lru_list_, iter->second);
+    return;
   }
+  lru_list_.push_front(value);
+  lru_map_.emplace(value, lru_list_.begin());
 }
 
 /* If LRU is non-empty, pop the head member from LRU to argument "value", and
  * return true. If LRU is empty, return false
  */
-template <typename T> 
+template <typename T>
 bool LRUReplacer<T>::Victim(T &value) {
-  if(Size() == 0)
+  if (lru_list_.empty())
     return false;
-  else {
-    T key ; int max = -1;
-    for(iter = lru_map.begin(); iter != lru_map.end(); iter++){
-      if((iter->second) > max){
-        max = iter->second;
-        key = iter->first;
-      }
-    }
-    value = key;
-    lru_map.erase(key);
-    size--;
-    return true;
-  }
+  value = lru_list_.back();
+  lru_map_.erase(value);
+  lru_list_.pop_back();
+  return true;
 }
 
 /*
  * Remove value from LRU. If removal is successful, return true, otherwise
  * return false
  */
-template <typename T> 
+template <typename T>
 bool LRUReplacer<T>::Erase(const T &value) {
-  if(lru_map.find(value) == lru_map.end())
+  auto iter = lru_map_.find(value);
+  if (iter == lru_map_.end())
     return false;
-  else {
-    lru_map.erase(value);
-    size--;
-    return true;
-  }
+  lru_list_.erase(iter->second);
+  lru_map_.erase(iter);
+  return true;
 }
 
-template <typename T> 
-size_t LRUReplacer<T>::Size() { 
-  return size; 
+template <typename T>
+size_t LRUReplacer<T>::Size() {
+  return lru_list_.size();
+}
+
+/*
+ * Walk the list from the least recently used end
+ */
+template <typename T>
+void LRUReplacer<T>::Peek(std::vector<T> &values, size_t max_count) {
+  for (auto iter = lru_list_.rbegin();
+       iter != lru_list_.rend() && max_count > 0; ++iter, --max_count) {
+    values.push_back(*iter);
+  }
 }
 
 template class LRUReplacer<Page *>;
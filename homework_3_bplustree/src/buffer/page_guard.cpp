@@ -0,0 +1,60 @@
+/**
+ * page_guard.cpp
+ */
+
+#include "buffer/page_guard.h"
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+PageGuard::PageGuard(BufferPoolManager *buffer_pool_manager, Page *page,
+                     bool exclusive)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page),
+      exclusive_(exclusive) {
+  if (page_ == nullptr) {
+    return;
+  }
+  if (exclusive_) {
+    page_->WLatch();
+  } else {
+    page_->RLatch();
+  }
+}
+
+PageGuard::PageGuard(PageGuard &&that) noexcept
+    : buffer_pool_manager_(that.buffer_pool_manager_), page_(that.page_),
+      exclusive_(that.exclusive_), is_dirty_(that.is_dirty_) {
+  that.page_ = nullptr;
+}
+
+/*
+ * The page held so far is released after that's page was latched, so moving
+ * the guard of a child into the guard of its parent is latch crabbing
+ */
+PageGuard &PageGuard::operator=(PageGuard &&that) noexcept {
+  if (this != &that) {
+    Release();
+    buffer_pool_manager_ = that.buffer_pool_manager_;
+    page_ = that.page_;
+    exclusive_ = that.exclusive_;
+    is_dirty_ = that.is_dirty_;
+    that.page_ = nullptr;
+  }
+  return *this;
+}
+
+void PageGuard::Release() {
+  if (page_ == nullptr) {
+    return;
+  }
+  if (exclusive_) {
+    page_->WUnlatch();
+  } else {
+    page_->RUnlatch();
+  }
+  buffer_pool_manager_->UnpinPage(page_, is_dirty_);
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+} // namespace scudb
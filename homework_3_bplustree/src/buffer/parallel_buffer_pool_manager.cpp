@@ -0,0 +1,223 @@
+#include "buffer/parallel_buffer_pool_manager.h"
+
+namespace scudb {
+
+/*
+ * ParallelBufferPoolManager Constructor
+ * Allocate num_instances buffer pool instances of pool_size frames each
+ */
+ParallelBufferPoolManager::ParallelBufferPoolManager(
+    size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+    LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManager(disk_manager, log_manager),
+      disk_manager_(disk_manager) {
+  if (num_instances == 0) {
+    num_instances = 1;
+  }
+  for (size_t i = 0; i < num_instances; ++i) {
+    instances_.push_back(new BufferPoolManager(pool_size, disk_manager,
+                                               log_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+/*
+ * Page ids are handed out sequentially by the disk manager, so a plain modulo
+ * spreads consecutive pages evenly over the instances
+ */
+BufferPoolManager *ParallelBufferPoolManager::GetInstance(page_id_t page_id) {
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+Page *ParallelBufferPoolManager::FetchPage(page_id_t page_id,
+                                           BufferAccessStrategy *strategy) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetInstance(page_id)->FetchPage(page_id, strategy);
+}
+
+Page *ParallelBufferPoolManager::FetchPageOptimistic(page_id_t page_id,
+                                                     uint64_t &version,
+                                                     Page *swizzled) {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetInstance(page_id)->FetchPageOptimistic(page_id, version, swizzled);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+bool ParallelBufferPoolManager::UnpinPage(Page *page, bool is_dirty) {
+  // the caller's pin keeps the frame on its page
+  return GetInstance(page->GetPageId())->UnpinPage(page, is_dirty);
+}
+
+bool ParallelBufferPoolManager::FlushPage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->FlushPage(page_id);
+}
+
+FlushStats ParallelBufferPoolManager::FlushAllPages() {
+  std::vector<Page *> dirty_pages;
+  std::vector<std::vector<Page *>> instance_dirty_pages(instances_.size());
+  std::vector<std::vector<Page *>> instance_busy_pages(instances_.size());
+  FlushStats stats;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    instances_[i]->BeginFlush(instance_dirty_pages[i], instance_busy_pages[i]);
+    dirty_pages.insert(dirty_pages.end(), instance_dirty_pages[i].begin(),
+                       instance_dirty_pages[i].end());
+  }
+  WritePageRuns(disk_manager_, dirty_pages, stats);
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    instances_[i]->EndFlush(instance_dirty_pages[i], instance_busy_pages[i]);
+  }
+  disk_manager_->Sync();
+  return stats;
+}
+
+/*
+ * The page id decides which instance holds the page, so allocate it first and
+ * then ask that instance for a frame. If every frame of that instance is
+ * pinned, retry: the next id lands in another instance. The ids tried are
+ * given back at the end, or a free space map would hand the same one out.
+ * return nullptr after trying each instance once
+ */
+Page *ParallelBufferPoolManager::NewPage(page_id_t &page_id) {
+  std::vector<page_id_t> tried;
+  Page *page = nullptr;
+  for (size_t i = 0; i < instances_.size() && page == nullptr; ++i) {
+    page_id_t new_page_id = disk_manager_->AllocatePage();
+    page = GetInstance(new_page_id)->NewPageWithId(new_page_id);
+    if (page != nullptr) {
+      page_id = new_page_id;
+    } else {
+      tried.push_back(new_page_id);
+    }
+  }
+  for (auto tried_page_id : tried) {
+    disk_manager_->DeallocatePage(tried_page_id);
+  }
+  return page;
+}
+
+bool ParallelBufferPoolManager::DeletePage(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetInstance(page_id)->DeletePage(page_id);
+}
+
+size_t ParallelBufferPoolManager::GetPoolSize() {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::ResizePool(size_t pool_size) {
+  bool resized = true;
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    size_t instance_pool_size = pool_size / instances_.size() +
+                                (i < pool_size % instances_.size() ? 1 : 0);
+    if (!instances_[i]->ResizePool(instance_pool_size)) {
+      resized = false;
+    }
+  }
+  return resized;
+}
+
+// each instance is asked for the pages it holds. A strategy ring is shared by
+// the instances, each one only recycles the frames of the ring it owns
+void ParallelBufferPoolManager::PrefetchPages(
+    const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(instances_.size());
+  for (auto page_id : page_ids) {
+    if (page_id != INVALID_PAGE_ID) {
+      instance_page_ids[static_cast<size_t>(page_id) % instances_.size()]
+          .push_back(page_id);
+    }
+  }
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (!instance_page_ids[i].empty()) {
+      instances_[i]->PrefetchPages(instance_page_ids[i], strategy);
+    }
+  }
+}
+
+std::vector<page_id_t> ParallelBufferPoolManager::GetResidentPages() {
+  std::vector<std::vector<page_id_t>> instance_page_ids;
+  for (auto *instance : instances_) {
+    instance_page_ids.push_back(instance->GetResidentPages());
+  }
+  std::vector<page_id_t> page_ids;
+  for (size_t rank = 0;; ++rank) {
+    size_t added = 0;
+    for (auto &resident : instance_page_ids) {
+      if (rank < resident.size()) {
+        page_ids.push_back(resident[rank]);
+        ++added;
+      }
+    }
+    if (added == 0) {
+      return page_ids;
+    }
+  }
+}
+
+void ParallelBufferPoolManager::RunCleanerThread(double dirty_ratio) {
+  for (auto *instance : instances_) {
+    instance->RunCleanerThread(dirty_ratio);
+  }
+}
+
+void ParallelBufferPoolManager::StopCleanerThread() {
+  for (auto *instance : instances_) {
+    instance->StopCleanerThread();
+  }
+}
+
+void ParallelBufferPoolManager::EnableVictimCache(size_t capacity) {
+  for (auto *instance : instances_) {
+    instance->EnableVictimCache(capacity / instances_.size());
+  }
+}
+
+size_t ParallelBufferPoolManager::GetVictimCacheSize() {
+  size_t size = 0;
+  for (auto *instance : instances_) {
+    size += instance->GetVictimCacheSize();
+  }
+  return size;
+}
+
+size_t ParallelBufferPoolManager::GetMemoryUsage() {
+  size_t size = 0;
+  for (auto *instance : instances_) {
+    size += instance->GetMemoryUsage();
+  }
+  return size;
+}
+
+BufferPoolStats ParallelBufferPoolManager::GetStats() {
+  BufferPoolStats stats;
+  for (auto *instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+} // namespace scudb
@@ -4,4 +4,10 @@ namespace scudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  std::chrono::milliseconds PAGE_CLEANER_TIMEOUT =
+   std::chrono::milliseconds(100);
+  size_t PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  size_t BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+  bool ENABLE_HUGE_PAGES = false;
+  bool ENABLE_OPTIMISTIC_WRITES = true;
 }
@@ -0,0 +1,108 @@
+/**
+ * epoch_manager.cpp
+ */
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/epoch_manager.h"
+
+namespace scudb {
+
+namespace {
+// epoch the thread entered its outermost guard in, 0 outside of any guard
+struct EpochSlot {
+  std::atomic<uint64_t> epoch{0};
+  bool in_use = false; // protected by registry latch
+  char padding_[64];
+};
+
+std::mutex &GetRegistryLatch() {
+  static std::mutex latch;
+  return latch;
+}
+
+// slots are reused by later threads, never freed
+std::vector<EpochSlot *> &GetRegistry() {
+  static std::vector<EpochSlot *> slots;
+  return slots;
+}
+
+struct ThreadEpoch {
+  ThreadEpoch() {
+    std::lock_guard<std::mutex> guard(GetRegistryLatch());
+    for (auto *registered : GetRegistry()) {
+      if (!registered->in_use) {
+        slot = registered;
+        break;
+      }
+    }
+    if (slot == nullptr) {
+      slot = new EpochSlot();
+      GetRegistry().push_back(slot);
+    }
+    slot->in_use = true;
+  }
+  ~ThreadEpoch() {
+    std::lock_guard<std::mutex> guard(GetRegistryLatch());
+    slot->in_use = false;
+  }
+
+  EpochSlot *slot = nullptr;
+  int depth = 0; // nested guards
+};
+
+ThreadEpoch &GetThreadEpoch() {
+  thread_local ThreadEpoch thread_epoch;
+  return thread_epoch;
+}
+} // namespace
+
+std::atomic<uint64_t> EpochManager::global_epoch_{1};
+
+/*
+ * The announcement must be visible before the reader loads any pointer, the
+ * full fence pairs with the one in Synchronize()
+ */
+void EpochManager::Enter() {
+  ThreadEpoch &thread_epoch = GetThreadEpoch();
+  if (thread_epoch.depth++ > 0) {
+    return;
+  }
+  thread_epoch.slot->epoch.store(
+      global_epoch_.load(std::memory_order_relaxed),
+      std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochManager::Exit() {
+  ThreadEpoch &thread_epoch = GetThreadEpoch();
+  if (--thread_epoch.depth > 0) {
+    return;
+  }
+  thread_epoch.slot->epoch.store(0, std::memory_order_release);
+}
+
+/*
+ * A reader that announces the new epoch or a later one entered after the
+ * memory became unreachable, only the older ones are waited for
+ */
+void EpochManager::Synchronize() {
+  uint64_t epoch = global_epoch_.fetch_add(1) + 1;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::vector<EpochSlot *> slots;
+  {
+    std::lock_guard<std::mutex> guard(GetRegistryLatch());
+    slots = GetRegistry();
+  }
+  for (auto *slot : slots) {
+    uint64_t slot_epoch;
+    while ((slot_epoch = slot->epoch.load(std::memory_order_acquire)) != 0 &&
+           slot_epoch < epoch) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+} // namespace scudb
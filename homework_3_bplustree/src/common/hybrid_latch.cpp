@@ -0,0 +1,121 @@
+/**
+ * hybrid_latch.cpp
+ */
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "common/hybrid_latch.h"
+
+namespace scudb {
+
+#define LATCH_SPIN_NUM 64  // failed checks before yielding
+#define LATCH_YIELD_NUM 16 // yields before parking
+#define PARKING_BUCKET_NUM 64
+
+namespace {
+struct ParkingBucket {
+  std::mutex mutex;
+  std::condition_variable cv;
+};
+
+ParkingBucket &GetParkingBucket(const void *latch) {
+  static ParkingBucket buckets[PARKING_BUCKET_NUM];
+  return buckets[std::hash<const void *>()(latch) % PARKING_BUCKET_NUM];
+}
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+} // namespace
+
+void HybridLatch::WLock() {
+  // announce the writer, which holds back new readers...
+  Wait([](uint64_t state) { return (state & EXCLUSIVE) != 0; },
+       [](uint64_t state) { return state | EXCLUSIVE; });
+  // ...then wait for the readers already in
+  Wait([](uint64_t state) { return (state & SHARED_MASK) != 0; },
+       [](uint64_t state) { return state; });
+}
+
+/*
+ * Bumping the version fails every optimistic read that overlapped the
+ * exclusive section
+ */
+void HybridLatch::WUnlock() {
+  uint64_t state =
+      state_.fetch_add(VERSION_ONE - EXCLUSIVE, std::memory_order_release);
+  if (state & PARKED) {
+    Wake();
+  }
+}
+
+void HybridLatch::RLock() {
+  Wait(
+      [](uint64_t state) {
+        return (state & EXCLUSIVE) != 0 ||
+               (state & SHARED_MASK) == SHARED_MASK;
+      },
+      [](uint64_t state) { return state + SHARED_ONE; });
+}
+
+void HybridLatch::RUnlock() {
+  uint64_t state = state_.fetch_sub(SHARED_ONE, std::memory_order_release);
+  // the last reader out lets a waiting writer in
+  if ((state & PARKED) && (state & SHARED_MASK) == SHARED_ONE) {
+    Wake();
+  }
+}
+
+/*
+ * Wait until blocked(state) is false, then move the latch to next(state). A
+ * parked thread sets PARKED and checks the state again under the bucket mutex,
+ * and Wake() clears PARKED before notifying under that mutex, so a wake-up can
+ * not fall between the check and the wait
+ */
+template <typename Blocked, typename Next>
+void HybridLatch::Wait(Blocked blocked, Next next) {
+  for (int round = 0;; ++round) {
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    if (!blocked(state)) {
+      uint64_t desired = next(state);
+      if (desired == state) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return;
+      }
+      if (state_.compare_exchange_weak(state, desired,
+                                       std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (round < LATCH_SPIN_NUM) {
+      CpuRelax();
+    } else if (round < LATCH_SPIN_NUM + LATCH_YIELD_NUM) {
+      std::this_thread::yield();
+    } else {
+      ParkingBucket &bucket = GetParkingBucket(this);
+      std::unique_lock<std::mutex> lock(bucket.mutex);
+      state = state_.fetch_or(PARKED, std::memory_order_relaxed) | PARKED;
+      if (blocked(state)) {
+        bucket.cv.wait(lock);
+      }
+    }
+  }
+}
+
+void HybridLatch::Wake() {
+  state_.fetch_and(~PARKED, std::memory_order_relaxed);
+  ParkingBucket &bucket = GetParkingBucket(this);
+  std::lock_guard<std::mutex> lock(bucket.mutex);
+  bucket.cv.notify_all();
+}
+
+} // namespace scudb
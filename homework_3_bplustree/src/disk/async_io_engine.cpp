@@ -0,0 +1,331 @@
+/**
+ * async_io_engine.cpp
+ */
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "common/logger.h"
+#include "disk/async_io_engine.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define SCUDB_HAS_IO_URING
+#endif
+#endif
+
+namespace scudb {
+
+namespace {
+
+// run a request synchronously, the thread pool and fallbacks use it
+ssize_t RunRequest(const AsyncIORequest &request) {
+  ssize_t result =
+      request.is_write
+          ? pwritev(request.fd, request.iovs.data(),
+                    static_cast<int>(request.iovs.size()), request.offset)
+          : preadv(request.fd, request.iovs.data(),
+                   static_cast<int>(request.iovs.size()), request.offset);
+  return result < 0 ? -errno : result;
+}
+
+class ThreadPoolEngine : public AsyncIOEngine {
+public:
+  ThreadPoolEngine() {
+    for (int i = 0; i < IO_WORKER_NUM; ++i) {
+      workers_.emplace_back(&ThreadPoolEngine::WorkerLoop, this);
+    }
+  }
+
+  // the queue is drained before the workers exit
+  ~ThreadPoolEngine() {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      running_ = false;
+    }
+    cv_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Submit(std::unique_ptr<AsyncIORequest> request) override {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      queue_.push_back(std::move(request));
+    }
+    cv_.notify_one();
+  }
+
+  const char *GetName() const override { return "thread_pool"; }
+
+private:
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(latch_);
+    while (true) {
+      cv_.wait(lock, [&] { return !running_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      std::unique_ptr<AsyncIORequest> request = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      request->callback(RunRequest(*request));
+      lock.lock();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::deque<std::unique_ptr<AsyncIORequest>> queue_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool running_ = true;
+};
+
+#ifdef SCUDB_HAS_IO_URING
+/*
+ * Submission and completion rings shared with the kernel. Submitters fill
+ * one SQE each under ring_latch_ and enter the kernel right away, so the
+ * kernel has consumed every SQE before the next one is filled. At most
+ * entries_ requests are in flight, counted under latch_, the completion ring
+ * (twice as large) never overflows. The reaper thread waits for completions;
+ * a NOP with no request attached tells it to stop. A request the kernel
+ * refuses runs synchronously on the submitting thread
+ */
+class IoUringEngine : public AsyncIOEngine {
+public:
+  // nullptr if io_uring can not be set up
+  static IoUringEngine *Open(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd =
+        static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    IoUringEngine *engine = new IoUringEngine(ring_fd, params);
+    if (!engine->Map(params)) {
+      delete engine;
+      return nullptr;
+    }
+    engine->reaper_ = std::thread(&IoUringEngine::ReaperLoop, engine);
+    return engine;
+  }
+
+  ~IoUringEngine() {
+    if (reaper_.joinable()) {
+      {
+        std::unique_lock<std::mutex> lock(latch_);
+        space_cv_.wait(lock, [&] { return in_flight_ == 0; });
+      }
+      {
+        std::lock_guard<std::mutex> guard(ring_latch_);
+        if (!Push(nullptr)) {
+          // the reaper finds out once io_uring_enter fails for it too
+          stopping_ = true;
+        }
+      }
+      reaper_.join();
+    }
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_ != nullptr) {
+      munmap(sq_ptr_, sq_size_);
+    }
+    close(ring_fd_);
+  }
+
+  void Submit(std::unique_ptr<AsyncIORequest> request) override {
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      space_cv_.wait(lock, [&] { return in_flight_ < entries_; });
+      ++in_flight_;
+    }
+    bool pushed;
+    {
+      std::lock_guard<std::mutex> guard(ring_latch_);
+      pushed = Push(request.get());
+    }
+    if (pushed) {
+      // the reaper owns it now
+      request.release();
+      return;
+    }
+    request->callback(RunRequest(*request));
+    Done();
+  }
+
+  const char *GetName() const override { return "io_uring"; }
+
+private:
+  IoUringEngine(int ring_fd, const struct io_uring_params &params)
+      : ring_fd_(ring_fd), entries_(params.sq_entries) {}
+
+  bool Map(const struct io_uring_params &params) {
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_size_ = std::max(sq_size_, cq_size_);
+    }
+    sq_ptr_ = MapRing(sq_size_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == nullptr) {
+      return false;
+    }
+    cq_ptr_ = single_mmap ? sq_ptr_ : MapRing(cq_size_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == nullptr) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe *>(
+        MapRing(sqes_size_, IORING_OFF_SQES));
+    if (sqes_ == nullptr) {
+      return false;
+    }
+    char *sq = static_cast<char *>(sq_ptr_);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  void *MapRing(size_t size, off_t offset) {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+
+  // fill the next SQE with request, a NOP if nullptr, and submit it. Return
+  // false if the kernel refused it, the SQE is taken back. Caller holds
+  // ring_latch_
+  bool Push(AsyncIORequest *request) {
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    struct io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    if (request == nullptr) {
+      sqe->opcode = IORING_OP_NOP;
+    } else {
+      sqe->opcode = request->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = request->fd;
+      sqe->off = static_cast<uint64_t>(request->offset);
+      sqe->addr = reinterpret_cast<uint64_t>(request->iovs.data());
+      sqe->len = static_cast<uint32_t>(request->iovs.size());
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+      if (errno == EAGAIN || errno == EBUSY) {
+        // out of kernel resources or completion ring space, give the reaper
+        // time to drain it
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      } else if (errno != EINTR) {
+        LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+        // the kernel consumed every earlier SQE before ring_latch_ was
+        // released, the failed call left only this one
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // a request left the ring
+  void Done() {
+    {
+      std::lock_guard<std::mutex> guard(latch_);
+      --in_flight_;
+    }
+    space_cv_.notify_all();
+  }
+
+  void ReaperLoop() {
+    while (true) {
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        if (stopping_) {
+          return;
+        }
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                nullptr, 0);
+        continue;
+      }
+      struct io_uring_cqe *cqe = &cqes_[head & cq_mask_];
+      auto *request = reinterpret_cast<AsyncIORequest *>(cqe->user_data);
+      ssize_t result = cqe->res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      if (request == nullptr) {
+        return;
+      }
+      // a short transfer is left to the callback, as with preadv/pwritev
+      request->callback(result);
+      delete request;
+      Done();
+    }
+  }
+
+  int ring_fd_;
+  unsigned entries_;
+  void *sq_ptr_ = nullptr;
+  void *cq_ptr_ = nullptr;
+  size_t sq_size_ = 0;
+  size_t cq_size_ = 0;
+  size_t sqes_size_ = 0;
+  unsigned *sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned *sq_array_ = nullptr;
+  struct io_uring_sqe *sqes_ = nullptr;
+  unsigned *cq_head_ = nullptr;
+  unsigned *cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  struct io_uring_cqe *cqes_ = nullptr;
+
+  std::mutex ring_latch_; // submitters filling SQEs
+  std::mutex latch_;      // in_flight_
+  std::condition_variable space_cv_;
+  unsigned in_flight_ = 0;
+  std::atomic<bool> stopping_{false};
+  std::thread reaper_;
+};
+#endif
+
+} // namespace
+
+AsyncIOEngine *AsyncIOEngine::Create(bool use_io_uring) {
+#ifdef SCUDB_HAS_IO_URING
+  if (use_io_uring) {
+    AsyncIOEngine *engine = IoUringEngine::Open(IO_QUEUE_DEPTH);
+    if (engine != nullptr) {
+      return engine;
+    }
+    LOG_DEBUG("io_uring not available, using a thread pool");
+  }
+#endif
+  return new ThreadPoolEngine();
+}
+
+} // namespace scudb
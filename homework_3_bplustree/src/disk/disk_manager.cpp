@@ -1,11 +1,19 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <new>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <thread>
+#include <unistd.h>
 
 #include "common/logger.h"
 #include "disk/disk_manager.h"
@@ -17,8 +25,9 @@ static char *buffer_used = nullptr;
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input direct_io: bypass the kernel page cache for page I/O
  */
-DiskManager::DiskManager(const std::string &db_file)
+DiskManager::DiskManager(const std::string &db_file, bool direct_io)
     : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
       flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.find(".");
@@ -42,62 +51,286 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // page I/O is positional, threads do not share a file position
+  int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);
+    if (db_fd_ < 0) {
+      LOG_DEBUG("O_DIRECT not supported, using buffered I/O");
+    } else {
+      direct_io_ = true;
+    }
+  }
+#endif
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), flags, 0644);
   }
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can not open db file");
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    file_size_ = stat_buf.st_size;
+  }
+  ResetNextPageId();
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  // waits for the requests in flight
+  delete io_engine_.load();
   log_io_.close();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file. It reaches the
+ * kernel, or the device with direct I/O, but is only durable after Sync()
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  WritePages(page_id, {page_data});
+}
+
+/**
+ * Write a run of consecutive pages, the first one being page_id, with one
+ * pwritev per IOV_MAX pages
+ */
+void DiskManager::WritePages(page_id_t page_id,
+                             const std::vector<const char *> &pages_data) {
+  if (pages_data.empty()) {
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  std::vector<struct iovec> iovs(pages_data.size());
+  for (size_t i = 0; i < pages_data.size(); ++i) {
+    iovs[i].iov_base = const_cast<char *>(pages_data[i]);
+    iovs[i].iov_len = PAGE_SIZE;
+  }
+  // direct I/O needs aligned buffers, copy the others into scratch
+  char *scratch = nullptr;
+  if (direct_io_) {
+    for (size_t i = 0; i < pages_data.size(); ++i) {
+      if (IsAligned(pages_data[i])) {
+        continue;
+      }
+      if (scratch == nullptr) {
+        scratch = AllocateAligned(pages_data.size() * PAGE_SIZE);
+      }
+      memcpy(scratch + i * PAGE_SIZE, pages_data[i], PAGE_SIZE);
+      iovs[i].iov_base = scratch + i * PAGE_SIZE;
+    }
+  }
+  for (size_t first = 0; first < iovs.size(); first += IOV_MAX) {
+    int count = static_cast<int>(
+        std::min(iovs.size() - first, static_cast<size_t>(IOV_MAX)));
+    off_t offset = static_cast<off_t>(page_id + first) * PAGE_SIZE;
+    ssize_t written = pwritev(db_fd_, &iovs[first], count, offset);
+    if (written < 0 && errno == EINVAL && StopDirectIO()) {
+      written = pwritev(db_fd_, &iovs[first], count, offset);
+    }
+    if (written != static_cast<ssize_t>(count * PAGE_SIZE)) {
+      LOG_DEBUG("I/O error while writing");
+      break;
+    }
+    GrowFileSize(offset + written);
+  }
+  free(scratch);
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Read the contents of the specified page into the given memory area. Past
+ * the end of the file, the page reads as zeros
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  if (offset >= file_size_.load(std::memory_order_relaxed)) {
+    LOG_DEBUG("read beyond file length");
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  char *buffer = page_data;
+  if (direct_io_ && !IsAligned(page_data)) {
+    buffer = AllocateAligned(PAGE_SIZE);
+  }
+  ssize_t read_count = pread(db_fd_, buffer, PAGE_SIZE, offset);
+  if (read_count < 0 && errno == EINVAL && StopDirectIO()) {
+    read_count = pread(db_fd_, buffer, PAGE_SIZE, offset);
+  }
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    read_count = 0;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (static_cast<size_t>(read_count) < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(buffer + read_count, 0, PAGE_SIZE - read_count);
+  }
+  if (buffer != page_data) {
+    memcpy(page_data, buffer, PAGE_SIZE);
+    free(buffer);
+  }
+}
+
+/**
+ * Make the pages written so far durable
+ */
+void DiskManager::Sync() {
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+  }
+}
+
+/*
+ * Called when the file system refused an O_DIRECT transfer: turn O_DIRECT
+ * off on the descriptor. return true if the caller should retry
+ */
+bool DiskManager::StopDirectIO() {
+#ifdef O_DIRECT
+  if (direct_io_.exchange(false)) {
+    LOG_DEBUG("O_DIRECT transfer refused, using buffered I/O");
+    fcntl(db_fd_, F_SETFL, fcntl(db_fd_, F_GETFL) & ~O_DIRECT);
+    return true;
+  }
+  // another thread turned it off meanwhile
+  return (fcntl(db_fd_, F_GETFL) & O_DIRECT) == 0;
+#else
+  return false;
+#endif
+}
+
+void DiskManager::GrowFileSize(long long size) {
+  long long file_size = file_size_.load(std::memory_order_relaxed);
+  while (file_size < size &&
+         !file_size_.compare_exchange_weak(file_size, size)) {
+  }
+}
+
+bool DiskManager::IsAligned(const char *page_data) {
+  return reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+char *DiskManager::AllocateAligned(size_t size) {
+  void *buffer = nullptr;
+  if (posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, size) != 0) {
+    throw std::bad_alloc();
+  }
+  return static_cast<char *>(buffer);
+}
+
+/**
+ * Queue an asynchronous page read on the I/O engine, starting it first if
+ * needed. page_data must stay valid until callback is called
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data,
+                                std::function<void()> callback) {
+  std::unique_ptr<AsyncIORequest> request(new AsyncIORequest);
+  request->fd = db_fd_;
+  request->offset = static_cast<off_t>(page_id) * PAGE_SIZE;
+  char *buffer = page_data;
+  if (direct_io_ && !IsAligned(page_data)) {
+    buffer = AllocateAligned(PAGE_SIZE);
+  }
+  request->iovs.push_back({buffer, PAGE_SIZE});
+  request->callback = [this, page_id, page_data, buffer,
+                       callback](ssize_t result) {
+    if (result == -EINVAL && StopDirectIO()) {
+      ReadPage(page_id, buffer);
+      result = PAGE_SIZE;
+    } else if (result < 0) {
+      LOG_DEBUG("I/O error while reading");
+      result = 0;
+    }
+    // past the end of the file, the page reads as zeros
+    if (static_cast<size_t>(result) < PAGE_SIZE) {
+      memset(buffer + result, 0, PAGE_SIZE - result);
+    }
+    if (buffer != page_data) {
+      memcpy(page_data, buffer, PAGE_SIZE);
+      free(buffer);
+    }
+    callback();
+  };
+  GetIOEngine()->Submit(std::move(request));
+}
+
+void DiskManager::WritePageAsync(page_id_t page_id, const char *page_data,
+                                 std::function<void()> callback) {
+  WritePagesAsync(page_id, {page_data}, std::move(callback));
+}
+
+/**
+ * One request per IOV_MAX pages, callback is called once all of them are
+ * done. Unaligned pages of a direct I/O write are copied into a scratch
+ * buffer that lives until then
+ */
+void DiskManager::WritePagesAsync(page_id_t page_id,
+                                  const std::vector<const char *> &pages_data,
+                                  std::function<void()> callback) {
+  if (pages_data.empty()) {
+    callback();
+    return;
+  }
+  std::vector<const char *> buffers(pages_data);
+  std::shared_ptr<char> scratch;
+  if (direct_io_) {
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      if (IsAligned(buffers[i])) {
+        continue;
+      }
+      if (scratch == nullptr) {
+        scratch.reset(AllocateAligned(buffers.size() * PAGE_SIZE), free);
+      }
+      memcpy(scratch.get() + i * PAGE_SIZE, buffers[i], PAGE_SIZE);
+      buffers[i] = scratch.get() + i * PAGE_SIZE;
     }
   }
+  size_t num_requests = (buffers.size() + IOV_MAX - 1) / IOV_MAX;
+  auto pending = std::make_shared<std::atomic<size_t>>(num_requests);
+  for (size_t first = 0; first < buffers.size(); first += IOV_MAX) {
+    size_t count =
+        std::min(buffers.size() - first, static_cast<size_t>(IOV_MAX));
+    std::vector<const char *> run(buffers.begin() + first,
+                                  buffers.begin() + first + count);
+    std::unique_ptr<AsyncIORequest> request(new AsyncIORequest);
+    request->is_write = true;
+    request->fd = db_fd_;
+    request->offset = static_cast<off_t>(page_id + first) * PAGE_SIZE;
+    for (const char *buffer : run) {
+      request->iovs.push_back({const_cast<char *>(buffer), PAGE_SIZE});
+    }
+    off_t offset = request->offset;
+    page_id_t run_page_id = page_id + static_cast<page_id_t>(first);
+    request->callback = [this, run, run_page_id, offset, scratch, pending,
+                         callback](ssize_t result) {
+      if (result == -EINVAL && StopDirectIO()) {
+        WritePages(run_page_id, run);
+      } else if (result != static_cast<ssize_t>(run.size() * PAGE_SIZE)) {
+        LOG_DEBUG("I/O error while writing");
+      } else {
+        GrowFileSize(offset + result);
+      }
+      if (--*pending == 0) {
+        callback();
+      }
+    };
+    GetIOEngine()->Submit(std::move(request));
+  }
+}
+
+const char *DiskManager::GetIOEngineName() { return GetIOEngine()->GetName(); }
+
+AsyncIOEngine *DiskManager::GetIOEngine() {
+  AsyncIOEngine *io_engine = io_engine_.load(std::memory_order_acquire);
+  if (io_engine != nullptr) {
+    return io_engine;
+  }
+  std::lock_guard<std::mutex> guard(io_engine_latch_);
+  if (io_engine_.load() == nullptr) {
+    io_engine_.store(AsyncIOEngine::Create());
+  }
+  return io_engine_.load();
 }
 
 /**
@@ -158,18 +391,40 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * A freed page if the free space map has one, else the page after the last
+ * one, skipping bitmap pages
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage() {
+  FreeSpaceMap *free_space_map = free_space_map_.load();
+  if (free_space_map == nullptr) {
+    return next_page_id_++;
+  }
+  page_id_t page_id = free_space_map->Allocate(next_page_id_);
+  while (page_id == INVALID_PAGE_ID ||
+         free_space_map->IsBitmapPage(page_id)) {
+    page_id = next_page_id_++;
+  }
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * Without a free space map, the page is lost
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  FreeSpaceMap *free_space_map = free_space_map_.load();
+  if (free_space_map != nullptr) {
+    free_space_map->Deallocate(page_id);
+  }
+}
+
+page_id_t DiskManager::GetNumPages() {
+  long long size = file_size_.load(std::memory_order_relaxed);
+  return size <= 0 ? 0 : static_cast<page_id_t>((size - 1) / PAGE_SIZE + 1);
 }
 
+void DiskManager::ResetNextPageId() { next_page_id_ = GetNumPages(); }
+
 /**
  * Returns number of flushes made so far
  */
@@ -183,7 +438,7 @@ bool DiskManager::GetFlushState() const { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+long long DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
@@ -0,0 +1,98 @@
+/**
+ * free_space_map.cpp
+ */
+
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "disk/free_space_map.h"
+
+namespace scudb {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager)
+    : buffer_pool_manager_(buffer_pool_manager),
+      bits_per_page_(static_cast<page_id_t>(PAGE_SIZE * 8)) {}
+
+// first set bit of bitmap in [from, to), or INVALID_PAGE_ID
+static page_id_t FindSetBit(const char *bitmap, page_id_t from, page_id_t to) {
+  for (page_id_t bit = from; bit < to; bit = (bit / 8 + 1) * 8) {
+    uint8_t byte = static_cast<uint8_t>(bitmap[bit / 8]) >> (bit % 8);
+    if (byte != 0) {
+      bit += __builtin_ctz(byte);
+      return bit < to ? bit : INVALID_PAGE_ID;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+/*
+ * Scan the bitmap pages from first_free_ on and clear the first set bit. Only
+ * bitmap pages below end exist, a scan finding nothing moves first_free_ to
+ * end so the next allocations skip it
+ */
+page_id_t FreeSpaceMap::Allocate(page_id_t end) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!unsaved_.empty()) {
+    page_id_t page_id = unsaved_.back();
+    unsaved_.pop_back();
+    return page_id;
+  }
+  page_id_t page_id = std::max<page_id_t>(first_free_, FREE_SPACE_MAP_PAGE_ID);
+  while (page_id < end) {
+    page_id_t bitmap_page_id = GetBitmapPageId(page_id);
+    page_id_t first = bitmap_page_id + 1;
+    page_id_t last = std::min(first + bits_per_page_, end);
+    Page *page = buffer_pool_manager_->FetchPage(bitmap_page_id);
+    if (page == nullptr) {
+      return INVALID_PAGE_ID;
+    }
+    page->WLatch();
+    page_id_t bit = FindSetBit(page->GetData(),
+                               std::max(page_id, first) - first, last - first);
+    if (bit != INVALID_PAGE_ID) {
+      page->GetData()[bit / 8] &= static_cast<char>(~(1 << (bit % 8)));
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(bitmap_page_id, bit != INVALID_PAGE_ID);
+    if (bit != INVALID_PAGE_ID) {
+      first_free_ = first + bit + 1;
+      return first + bit;
+    }
+    // first page of the next bitmap page
+    page_id = first + bits_per_page_;
+  }
+  first_free_ = std::max(first_free_, end);
+  return INVALID_PAGE_ID;
+}
+
+void FreeSpaceMap::Deallocate(page_id_t page_id) {
+  if (page_id <= HEADER_PAGE_ID || IsBitmapPage(page_id)) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  page_id_t bitmap_page_id = GetBitmapPageId(page_id);
+  Page *page = buffer_pool_manager_->FetchPage(bitmap_page_id);
+  if (page == nullptr) {
+    unsaved_.push_back(page_id);
+    return;
+  }
+  page_id_t bit = page_id - bitmap_page_id - 1;
+  page->WLatch();
+  page->GetData()[bit / 8] |= static_cast<char>(1 << (bit % 8));
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bitmap_page_id, true);
+  first_free_ = std::min(first_free_, page_id);
+}
+
+bool FreeSpaceMap::IsBitmapPage(page_id_t page_id) const {
+  return page_id >= FREE_SPACE_MAP_PAGE_ID &&
+         (page_id - FREE_SPACE_MAP_PAGE_ID) % (bits_per_page_ + 1) == 0;
+}
+
+page_id_t FreeSpaceMap::GetBitmapPageId(page_id_t page_id) const {
+  page_id_t stride = bits_per_page_ + 1;
+  return FREE_SPACE_MAP_PAGE_ID +
+         (page_id - FREE_SPACE_MAP_PAGE_ID) / stride * stride;
+}
+
+} // namespace scudb
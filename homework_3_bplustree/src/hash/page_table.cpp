@@ -0,0 +1,180 @@
+/**
+ * page_table.cpp
+ */
+
+#include "hash/page_table.h"
+
+namespace scudb {
+
+PageTable::Table::Table(size_t num_slots)
+    : slots(new Slot[num_slots]), mask(num_slots - 1), shift(64) {
+  while (num_slots > 1) {
+    num_slots >>= 1;
+    --shift;
+  }
+}
+
+/*
+ * At most half of the slots are used, so probe sequences stay short
+ */
+PageTable::PageTable(size_t capacity) {
+  size_t num_slots = 16;
+  while (num_slots < 2 * capacity) {
+    num_slots <<= 1;
+  }
+  table_.store(new Table(num_slots));
+}
+
+PageTable::~PageTable() {
+  delete table_.load();
+  for (auto *table : retired_) {
+    delete table;
+  }
+}
+
+/*
+ * Lock free. Writers never change the frame of a slot while it holds a page
+ * id: the slot is emptied first, then given its frame, then its page id. So
+ * the frame is returned only if the page id is still there once it is loaded
+ */
+bool PageTable::Find(page_id_t page_id, Page *&frame) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  Table *table = table_.load(std::memory_order_acquire);
+  size_t slot = table->Home(page_id);
+  for (size_t probes = 0; probes <= table->mask; ++probes) {
+    page_id_t slot_page_id =
+        table->slots[slot].page_id.load(std::memory_order_acquire);
+    if (slot_page_id == page_id) {
+      Page *slot_frame = table->slots[slot].frame.load(std::memory_order_acquire);
+      if (table->slots[slot].page_id.load(std::memory_order_acquire) !=
+          page_id) {
+        return false;
+      }
+      frame = slot_frame;
+      return true;
+    }
+    if (slot_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    slot = (slot + 1) & table->mask;
+  }
+  return false;
+}
+
+bool PageTable::Insert(page_id_t page_id, Page *frame) {
+  std::lock_guard<std::mutex> guard(write_latch_);
+  Table *table = table_.load(std::memory_order_relaxed);
+  size_t slot = table->Home(page_id);
+  while (true) {
+    page_id_t slot_page_id =
+        table->slots[slot].page_id.load(std::memory_order_relaxed);
+    if (slot_page_id == page_id) {
+      return false;
+    }
+    if (slot_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    slot = (slot + 1) & table->mask;
+  }
+  if ((size_ + 1) * 2 > table->mask + 1) {
+    Grow();
+    table = table_.load(std::memory_order_relaxed);
+  }
+  Place(table, page_id, frame);
+  ++size_;
+  return true;
+}
+
+/*
+ * Backward shift deletion: walk the cluster after the removed slot and move
+ * back every entry whose home slot allows it, so that no probe sequence ever
+ * crosses an empty slot before reaching its entry
+ */
+bool PageTable::Remove(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(write_latch_);
+  Table *table = table_.load(std::memory_order_relaxed);
+  size_t hole = table->Home(page_id);
+  while (true) {
+    page_id_t slot_page_id =
+        table->slots[hole].page_id.load(std::memory_order_relaxed);
+    if (slot_page_id == page_id) {
+      break;
+    }
+    if (slot_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    hole = (hole + 1) & table->mask;
+  }
+  size_t slot = hole;
+  while (true) {
+    slot = (slot + 1) & table->mask;
+    page_id_t slot_page_id =
+        table->slots[slot].page_id.load(std::memory_order_relaxed);
+    if (slot_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    // the entry can not move before its home slot
+    size_t home = table->Home(slot_page_id);
+    if (((slot - home) & table->mask) < ((slot - hole) & table->mask)) {
+      continue;
+    }
+    Store(table->slots[hole], slot_page_id,
+          table->slots[slot].frame.load(std::memory_order_relaxed));
+    hole = slot;
+  }
+  table->slots[hole].page_id.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+  table->slots[hole].frame.store(nullptr, std::memory_order_release);
+  --size_;
+  return true;
+}
+
+size_t PageTable::GetSize() {
+  std::lock_guard<std::mutex> guard(write_latch_);
+  return size_;
+}
+
+size_t PageTable::GetCapacity() {
+  std::lock_guard<std::mutex> guard(write_latch_);
+  return (table_.load(std::memory_order_relaxed)->mask + 1) / 2;
+}
+
+void PageTable::Grow() {
+  Table *table = table_.load(std::memory_order_relaxed);
+  Table *new_table = new Table(2 * (table->mask + 1));
+  for (size_t slot = 0; slot <= table->mask; ++slot) {
+    page_id_t page_id =
+        table->slots[slot].page_id.load(std::memory_order_relaxed);
+    if (page_id != INVALID_PAGE_ID) {
+      Place(new_table, page_id,
+            table->slots[slot].frame.load(std::memory_order_relaxed));
+    }
+  }
+  table_.store(new_table, std::memory_order_release);
+  retired_.push_back(table);
+}
+
+void PageTable::Place(Table *table, page_id_t page_id, Page *frame) {
+  size_t slot = table->Home(page_id);
+  while (table->slots[slot].page_id.load(std::memory_order_relaxed) !=
+         INVALID_PAGE_ID) {
+    slot = (slot + 1) & table->mask;
+  }
+  Store(table->slots[slot], page_id, frame);
+}
+
+/*
+ * A reader that loads the new frame (acquire) sees the slot emptied, so it
+ * can not pair the new frame with the page id the slot held before
+ */
+void PageTable::Store(Slot &slot, page_id_t page_id, Page *frame) {
+  slot.page_id.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+  slot.frame.store(frame, std::memory_order_release);
+  slot.page_id.store(page_id, std::memory_order_release);
+}
+
+} // namespace scudb
@@ -0,0 +1,45 @@
+/**
+ * buffer_access_strategy.h
+ *
+ * Functionality: A private ring of frames for one large sequential scan. When
+ * a page fetched through the strategy misses, the buffer pool manager recycles
+ * the frame the scan used ring_size pages ago instead of asking the shared
+ * replacer for a victim, so a full table scan only ever occupies ring_size
+ * frames and cannot flush the hot pages of other workloads out of the pool.
+ *
+ * A strategy belongs to one scan and is only used by the buffer pool manager,
+ * under its latch. A frame of the ring is only recycled if it still holds the
+ * page the scan read into it and nobody pins it; otherwise the ring takes a
+ * fresh victim from the shared pool for that slot.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "page/page.h"
+
+namespace scudb {
+
+class BufferAccessStrategy {
+  friend class BufferPoolManager;
+
+public:
+  explicit BufferAccessStrategy(size_t ring_size = SCAN_RING_SIZE)
+      : ring_size_(ring_size == 0 ? 1 : ring_size) {}
+
+  inline size_t GetRingSize() const { return ring_size_; }
+
+private:
+  struct Slot {
+    Page *page;
+    page_id_t page_id; // page the scan read into the frame
+  };
+
+  size_t ring_size_;
+  std::vector<Slot> ring_;
+  size_t next_ = 0; // slot to recycle next
+};
+
+} // namespace scudb
@@ -7,41 +7,237 @@
  */
 
 #pragma once
+#include <condition_variable>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_slab.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_guard.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
+#include "hash/page_table.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
 namespace scudb {
+// what a FlushAllPages() call wrote back
+struct FlushStats {
+  size_t num_pages = 0;  // dirty pages written
+  size_t num_bytes = 0;  // bytes written
+  size_t num_writes = 0; // disk writes, one per run of consecutive pages
+};
+
 class BufferPoolManager {
+  friend class ParallelBufferPoolManager;
+
 public:
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                          LogManager *log_manager = nullptr,
+                          ReplacerType replacer_type = ReplacerType::LRU);
+
+  virtual ~BufferPoolManager();
+
+  // with a strategy, a miss recycles a frame of the strategy's ring instead of
+  // a victim of the shared pool
+  virtual Page *FetchPage(page_id_t page_id,
+                          BufferAccessStrategy *strategy = nullptr);
+
+  virtual bool UnpinPage(page_id_t page_id, bool is_dirty);
+  // unpin a frame the caller has pinned, without looking its page up. latch_
+  // is only taken for the last pin
+  virtual bool UnpinPage(Page *page, bool is_dirty);
+
+  // fetch a page and latch it, shared or exclusive. The guard unlatches and
+  // unpins the page when it goes out of scope. The guard is invalid if all
+  // the frames are pinned
+  ReadPageGuard FetchPageRead(page_id_t page_id,
+                              BufferAccessStrategy *strategy = nullptr);
+  WritePageGuard FetchPageWrite(page_id_t page_id);
+  // new page, write latched and unpinned as dirty
+  WritePageGuard NewPageGuarded(page_id_t &page_id);
+
+  // resident page for an optimistic read, neither pinned nor latched, with the
+  // latch version to check with Page::ValidateLatch() once read. nullptr if
+  // the page is not resident, still loading or write latched. Call it inside
+  // an EpochGuard: the frame content stays allocated until the guard ends.
+  // swizzled is a frame that held the page lately, if it still does the page
+  // table is not searched
+  virtual Page *FetchPageOptimistic(page_id_t page_id, uint64_t &version,
+                                    Page *swizzled = nullptr);
+
+  virtual bool FlushPage(page_id_t page_id);
 
-  ~BufferPoolManager();
+  // write back every dirty page, in page id order, coalescing consecutive
+  // pages into one disk write, then sync the db file once. Pages dirtied
+  // before the call are durable when it returns
+  virtual FlushStats FlushAllPages();
 
-  Page *FetchPage(page_id_t page_id);
+  virtual Page *NewPage(page_id_t &page_id);
 
-  bool UnpinPage(page_id_t page_id, bool is_dirty);
+  virtual bool DeletePage(page_id_t page_id);
 
-  bool FlushPage(page_id_t page_id);
+  virtual size_t GetPoolSize() { return pool_size_; }
 
-  Page *NewPage(page_id_t &page_id);
+  // change the number of frames while the pool is in use. Growing adds empty
+  // frames to the free list. Shrinking gives up free frames first, then evicts
+  // unpinned frames from the cold end of the replacer, writing dirty ones
+  // back. return false if pinned or busy frames kept the pool from reaching
+  // pool_size, the pool is then as small as it could get
+  virtual bool ResizePool(size_t pool_size);
 
-  bool DeletePage(page_id_t page_id);
+  // read-ahead: start loading the pages on the disk manager I/O workers and
+  // return at once. Loaded pages are not pinned, a later FetchPage() of one
+  // of them waits for its read if still in flight. Pages are only read into
+  // free or clean frames, prefetching never forces a write-back
+  virtual void PrefetchPages(const std::vector<page_id_t> &page_ids,
+                             BufferAccessStrategy *strategy = nullptr);
+
+  // page ids held by the pool, hottest first: pinned pages, then the others
+  // from the hot end of the replacer. Saved on shutdown to warm up the pool
+  virtual std::vector<page_id_t> GetResidentPages();
+  // prefetch the hottest of page_ids, hottest first, as many as the pool
+  // holds. They are read in page id order, spread over the I/O workers, and
+  // served as soon as they arrive
+  void WarmUp(std::vector<page_id_t> page_ids);
+
+  // spawn a page cleaner thread writing back dirty unpinned frames from the
+  // cold end of the replacer, until at most dirty_ratio of the pool is dirty
+  virtual void RunCleanerThread(double dirty_ratio = PAGE_CLEANER_DIRTY_RATIO);
+  // stop and join the page cleaner, call it before deleting the disk manager
+  virtual void StopCleanerThread();
+
+  // keep evicted pages compressed in memory, up to capacity bytes, and serve
+  // misses from there before reading the disk. 0 turns it off again
+  virtual void EnableVictimCache(size_t capacity);
+  // bytes of compressed pages held, 0 if the victim cache is off
+  virtual size_t GetVictimCacheSize();
+
+  // let the disk manager allocate deleted pages again, tracking them in
+  // bitmap pages of this buffer pool. Call it before any other thread uses
+  // the buffer pool, once
+  virtual void EnableFreeSpaceMap();
+
+  // bytes of memory held for page content: the frame slab, mapped memory of
+  // free and retired frames included, and the victim cache
+  virtual size_t GetMemoryUsage();
+
+  // snapshot of the counters and latency histograms since construction
+  virtual BufferPoolStats GetStats() { return metrics_.GetStats(); }
+
+protected:
+  // for subclasses that keep their frames somewhere else
+  BufferPoolManager(DiskManager *disk_manager, LogManager *log_manager);
+  // sort pages by page id and write them back run by run
+  static void WritePageRuns(DiskManager *disk_manager,
+                            std::vector<Page *> &pages, FlushStats &stats);
 
 private:
+  // bring a page that was already allocated on disk into a fresh frame
+  Page *NewPageWithId(page_id_t page_id);
+  // find a frame to hold a new page, from free list first then replacer, may
+  // release latch_ to wait for the page cleaner
+  Page *GetVictimPage(std::unique_lock<std::mutex> &lock);
+  // free whatever frame still holds page_id, about to be handed out again,
+  // may release latch_ to wait for its users
+  void DropStaleCopy(page_id_t page_id, std::unique_lock<std::mutex> &lock);
+  // take page_id out of the pool, now or on its last unpin, may release
+  // latch_ to wait for its I/O. true if the page is to be deallocated
+  bool DropPage(page_id_t page_id, std::unique_lock<std::mutex> &lock);
+  // put a claimed, idle frame back on the free list
+  void FreeFrame(Page *page);
+  // take an unpinned frame out of latch free fetchers' reach and out of the
+  // replacer, false if it is pinned
+  bool ClaimFrame(Page *page);
+  // the last pin of page is gone, true if its page is to be deallocated
+  bool ReleaseFrame(Page *page, std::unique_lock<std::mutex> &lock);
+  // hand the victim frame over to page_id, pin it unless told otherwise and
+  // mark its I/O pending
+  void ReplaceFrame(Page *page, page_id_t page_id, bool pin = true);
+  // page table hit without latch_: pin page if it is not claimed and it still
+  // holds page_id, loaded
+  bool TryPinResident(Page *page, page_id_t page_id);
+  // bump the latch version of an unpinned frame before its content changes
+  // hands or goes away
+  void InvalidateFrame(Page *page);
+  // write back the evicted page and load page content, without holding latch_
+  void LoadFrame(Page *page, bool read_from_disk);
+  // block until the I/O on page is done, caller must hold latch_ through lock
+  void WaitForIO(Page *page, std::unique_lock<std::mutex> &lock);
+  // acquire latch_ through lock, timing the wait if it is contended
+  void LockLatch(std::unique_lock<std::mutex> &lock);
+  // disk manager reads and writes, counted and timed
+  void ReadFromDisk(page_id_t page_id, char *data);
+  void WriteToDisk(page_id_t page_id, const char *data);
+  // body of the page cleaner thread
+  void CleanerLoop();
+  // write back cold dirty frames, caller must hold latch_ through lock
+  void CleanColdPages(std::unique_lock<std::mutex> &lock);
+  // free or clean, idle frame for a prefetch, nullptr if there is none
+  Page *GetPrefetchFrame(BufferAccessStrategy *strategy);
+  // frame of the ring that can be recycled, nullptr if the ring is not full
+  // yet or none of its frames of this instance is idle
+  Page *GetRingVictim(BufferAccessStrategy *strategy, bool clean_only);
+  // record that page now holds a page read through strategy
+  void AddToRing(BufferAccessStrategy *strategy, Page *page);
+  // completion of a prefetch read, on an I/O worker thread
+  void FinishPrefetch(Page *page, bool from_disk);
+  // first half of FlushAllPages(): mark dirty frames I/O in progress and hand
+  // them out in dirty_pages, frames with I/O already in flight go to
+  // busy_pages
+  void BeginFlush(std::vector<Page *> &dirty_pages,
+                  std::vector<Page *> &busy_pages);
+  // second half, once dirty_pages are written: clear their I/O in progress
+  // flag and wait for busy_pages
+  void EndFlush(const std::vector<Page *> &dirty_pages,
+                const std::vector<Page *> &busy_pages);
+  // empty frame for a grown pool, reusing the header of a retired frame
+  Page *NewFrame();
+  // take unpinned frames out of the pool, caller must hold latch_ through
+  // lock. return false if no frame could be taken
+  bool ShrinkPool(size_t pool_size, std::unique_lock<std::mutex> &lock);
+  // drop the content of frames no longer in the pool
+  void RetireFrames(const std::vector<Page *> &frames);
+  // hand the page a frame is about to lose to the victim cache, if any
+  void ToVictimCache(Page *page, page_id_t page_id);
+  // write back and cache the page a frame gave up, see LoadFrame()
+  void FinishEviction(Page *page);
+  // load the page of the frame from the victim cache, false on a miss
+  bool ReadFromVictimCache(Page *page);
+
   size_t pool_size_; // number of pages in buffer pool
-  Page *pages_;      // array of pages
+  std::vector<Page *> pages_; // frames of the pool
+  FrameSlab *frame_slab_;      // memory of the frames, page size aligned
+  // frames given up by a shrink: their data is freed, but other threads may
+  // still hold a pointer to them while waiting on io_cv_, so the Page objects
+  // live until the buffer pool is deleted, or are reused by a grow
+  std::vector<Page *> retired_;
   DiskManager *disk_manager_;
   LogManager *log_manager_;
-  HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
+  PageTable *page_table_;        // to keep track of pages
   Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
   std::list<Page *> *free_list_; // to find a free page for replacement
   std::mutex latch_;             // to protect shared data structure
+  // evicted dirty pages whose write-back is in flight, and their frames
+  std::unordered_map<page_id_t, Page *> writing_back_;
+  // page cleaner
+  std::thread *cleaner_thread_ = nullptr;
+  bool cleaner_running_ = false;
+  double dirty_ratio_ = PAGE_CLEANER_DIRTY_RATIO;
+  std::condition_variable cleaner_cv_; // wake up the page cleaner early
+  // prefetch reads in flight, all done before the frames are freed
+  size_t prefetching_ = 0;
+  std::condition_variable prefetch_cv_;
+  BufferPoolMetrics metrics_;
+  // second tier of evicted pages, created by the first EnableVictimCache()
+  std::atomic<CompressedPageCache *> victim_cache_{nullptr};
+  // registered with the disk manager by EnableFreeSpaceMap()
+  FreeSpaceMap *free_space_map_ = nullptr;
 };
 } // namespace scudb
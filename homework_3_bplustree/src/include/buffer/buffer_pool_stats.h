@@ -0,0 +1,124 @@
+/**
+ * buffer_pool_stats.h
+ *
+ * Functionality: Counters and latency histograms of a buffer pool manager.
+ * BufferPoolMetrics is what the buffer pool updates on its hot paths: the
+ * counters are split into STATS_SHARD_NUM cache line padded shards and a
+ * thread always updates the same shard with relaxed atomic adds, so threads
+ * do not bounce each other's cache lines. BufferPoolStats is a snapshot, the
+ * sum of the shards, returned by BufferPoolManager::GetStats().
+ *
+ * Latencies are in nanoseconds, bucket i of a histogram counts the samples in
+ * [2^i, 2^(i+1)).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "common/config.h"
+
+namespace scudb {
+
+enum class StatCounter {
+  FETCH_HIT = 0,   // FetchPage() found the page in the pool
+  FETCH_MISS,      // FetchPage() had to read the page
+  NEW_PAGE,        // pages created by NewPage()
+  UNPIN,           // successful UnpinPage() calls
+  EVICTION,        // frames handed over to another page
+  DIRTY_EVICTION,  // evictions that had to write the old page back
+  FREE_LIST_EMPTY, // frame requests served by the replacer
+  NO_FREE_FRAME,   // frame requests failed, all the frames are pinned
+  PREFETCH,        // pages read ahead by PrefetchPages()
+  DISK_READ,       // pages read from disk
+  DISK_WRITE,      // pages written to disk
+  LATCH_WAIT,      // acquisitions of the pool latch that had to wait
+  LATCH_WAIT_NS,   // time spent waiting for the pool latch
+  VICTIM_CACHE_HIT,  // page reads served by the compressed page cache
+  VICTIM_CACHE_MISS, // page reads it could not serve
+  NUM_COUNTERS
+};
+
+enum class StatLatency {
+  FETCH_PAGE = 0,
+  NEW_PAGE,
+  UNPIN_PAGE,
+  DISK_READ,
+  DISK_WRITE,
+  NUM_LATENCIES
+};
+
+#define STATS_HISTOGRAM_BUCKETS 40 // up to 2^40 ns, about 18 minutes
+
+struct LatencyHistogram {
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t buckets[STATS_HISTOGRAM_BUCKETS] = {};
+
+  double MeanNs() const;
+  // upper bound of the bucket holding the p-th percentile, p in [0, 1]
+  uint64_t PercentileNs(double p) const;
+};
+
+struct BufferPoolStats {
+  uint64_t counters[static_cast<int>(StatCounter::NUM_COUNTERS)] = {};
+  LatencyHistogram latencies[static_cast<int>(StatLatency::NUM_LATENCIES)];
+
+  inline uint64_t Get(StatCounter counter) const {
+    return counters[static_cast<int>(counter)];
+  }
+  inline const LatencyHistogram &Get(StatLatency latency) const {
+    return latencies[static_cast<int>(latency)];
+  }
+  // fraction of FetchPage() calls that hit, 0 before the first fetch
+  double HitRatio() const;
+  // add up the stats of several pools
+  BufferPoolStats &operator+=(const BufferPoolStats &that);
+
+  // lower case names, e.g. "fetch_hit", "fetch_page"
+  static const char *GetName(StatCounter counter);
+  static const char *GetName(StatLatency latency);
+};
+
+class BufferPoolMetrics {
+public:
+  typedef std::chrono::steady_clock clock;
+
+  inline void Add(StatCounter counter, uint64_t value = 1) {
+    GetShard().counters[static_cast<int>(counter)].fetch_add(
+        value, std::memory_order_relaxed);
+  }
+  void Record(StatLatency latency, uint64_t ns);
+  inline void Record(StatLatency latency, clock::time_point start) {
+    Record(latency, static_cast<uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            clock::now() - start)
+                            .count()));
+  }
+
+  // sum of the shards, concurrent updates may or may not be seen
+  BufferPoolStats GetStats() const;
+
+private:
+  struct Histogram {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> buckets[STATS_HISTOGRAM_BUCKETS] = {};
+  };
+  // padded rather than aligned, a pool is allocated with plain new
+  struct Shard {
+    std::atomic<uint64_t>
+        counters[static_cast<int>(StatCounter::NUM_COUNTERS)] = {};
+    Histogram latencies[static_cast<int>(StatLatency::NUM_LATENCIES)];
+    char padding_[64];
+  };
+
+  Shard &GetShard();
+
+  Shard shards_[STATS_SHARD_NUM];
+};
+
+} // namespace scudb
@@ -0,0 +1,72 @@
+/**
+ * compressed_page_cache.h
+ *
+ * Functionality: Second tier of the buffer pool, between the frames and the
+ * disk manager. The buffer pool manager hands it the content of every page it
+ * evicts, which is kept compressed in memory, and asks it before reading a
+ * missing page from disk. A hit moves the page back into the pool, so a page
+ * is never held by both. When the compressed pages outgrow the capacity, the
+ * ones evicted longest ago are dropped, their copy on disk is up to date.
+ * The buffer pool manager inserts a page before anyone may fetch it again.
+ *
+ * Pages are compressed with a byte oriented LZ77: a token byte below 0x80 is
+ * followed by that many plus one literal bytes, a token byte from 0x80 stands
+ * for a match of (token & 0x7f) + 3 bytes, found at the 2 byte little endian
+ * offset that follows, before the current position. Zeroed page tails and
+ * repeated key prefixes take a few bytes each.
+ * */
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class CompressedPageCache {
+public:
+  // capacity: bytes of compressed page content kept at most
+  explicit CompressedPageCache(size_t capacity);
+
+  // keep the content of page_id (PAGE_SIZE bytes). A page that does not
+  // compress or fit only drops an older copy
+  void Insert(page_id_t page_id, const char *data);
+  // copy page_id into data (PAGE_SIZE bytes) and drop it from the cache
+  bool Take(page_id_t page_id, char *data);
+  void Erase(page_id_t page_id);
+
+  // dropping the copies evicted longest ago if needed
+  void SetCapacity(size_t capacity);
+  size_t GetCapacity();
+  size_t GetSize();     // bytes used
+  size_t GetNumPages(); // pages held
+
+  // compress size bytes of src into dst, return the compressed size, or 0 if
+  // it would take more than capacity bytes
+  static size_t Compress(const char *src, size_t size, char *dst,
+                         size_t capacity);
+  // return true if src decompresses to exactly size bytes
+  static bool Decompress(const char *src, size_t src_size, char *dst,
+                         size_t size);
+
+private:
+  struct Entry {
+    page_id_t page_id;
+    std::string data; // compressed content
+  };
+
+  // drop the entry of it, caller holds latch_
+  void Remove(std::list<Entry>::iterator it);
+
+  size_t capacity_;
+  size_t size_ = 0;
+  std::list<Entry> entries_; // last inserted first
+  std::unordered_map<page_id_t, std::list<Entry>::iterator> index_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
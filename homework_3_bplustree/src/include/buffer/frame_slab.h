@@ -0,0 +1,63 @@
+/**
+ * frame_slab.h
+ *
+ * Functionality: Memory of the buffer pool frames. Frames are carved out of
+ * large anonymous mappings (chunks) instead of one heap allocation each, so
+ * every frame is aligned on its own size and can be handed to O_DIRECT reads
+ * and writes as is. Chunks start small and double up to FRAME_SLAB_CHUNK_SIZE,
+ * a pool of a few frames does not map megabytes. With huge pages, chunks are
+ * FRAME_SLAB_CHUNK_SIZE and mapped with MAP_HUGETLB if the system has huge
+ * pages reserved, else they are only advised to be backed by transparent
+ * huge pages.
+ *
+ * A freed frame goes back to a free list of the slab, chunks are unmapped
+ * when the slab is deleted. The slab is not thread safe: the owning buffer
+ * pool manager allocates and frees under its latch.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class FrameSlab {
+public:
+  // frame_size: bytes of a frame, a power of two no larger than the system
+  // page size or a multiple of it
+  explicit FrameSlab(size_t frame_size, bool huge_pages = false);
+  ~FrameSlab();
+
+  FrameSlab(const FrameSlab &) = delete;
+  FrameSlab &operator=(const FrameSlab &) = delete;
+
+  // content of the frame is undefined
+  char *Allocate();
+  void Free(char *frame);
+
+  inline size_t GetFrameSize() const { return frame_size_; }
+  // bytes mapped, free frames included
+  inline size_t GetReservedBytes() const { return reserved_bytes_; }
+  // bytes of the frames handed out
+  inline size_t GetUsedBytes() const {
+    return reserved_bytes_ - free_frames_.size() * frame_size_;
+  }
+
+private:
+  struct Chunk {
+    char *base;
+    size_t size;
+  };
+  // map a new chunk and put its frames on the free list
+  void Grow();
+
+  size_t frame_size_;
+  bool huge_pages_;
+  size_t reserved_bytes_ = 0;
+  std::vector<Chunk> chunks_;
+  std::vector<char *> free_frames_;
+};
+
+} // namespace scudb
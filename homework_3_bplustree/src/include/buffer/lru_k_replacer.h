@@ -0,0 +1,70 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement policy. The replacer remembers the last K
+ * access timestamps of every value it has seen and evicts the evictable value
+ * whose backward K-distance (now - K-th most recent access) is the largest.
+ * Values with less than K recorded accesses have an infinite backward
+ * K-distance; among those the one with the earliest first access is evicted,
+ * so a one-off sequential scan cannot flush values that are used repeatedly.
+ *
+ * Access history survives Pin and PinHits (the value is only made
+ * non-evictable) and is dropped by Victim and Erase.
+ */
+
+#pragma once
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace scudb {
+
+template <typename T>
+class LRUKReplacer : public Replacer<T> {
+public:
+  explicit LRUKReplacer(size_t k = LRUK_REPLACER_K);
+
+  ~LRUKReplacer();
+
+  void Insert(const T &value) override;
+
+  bool Victim(T &value) override;
+
+  bool Erase(const T &value) override;
+
+  size_t Size() override;
+
+  bool Pin(const T &value) override;
+
+  void PinHits(const T &value, size_t count) override;
+
+  void Peek(std::vector<T> &values, size_t max_count) override;
+
+private:
+  struct Entry {
+    // at most k_ timestamps, front is the oldest one
+    std::deque<size_t> history_;
+    bool evictable_ = false;
+  };
+  typedef std::pair<size_t, T> rank_t;
+
+  void RecordAccess(Entry &entry);
+  // remove/add the value from/to the ordered set it belongs to
+  void Unlink(const T &value, const Entry &entry);
+  void Link(const T &value, const Entry &entry);
+
+  size_t k_;
+  size_t current_timestamp_ = 0;
+  std::unordered_map<T, Entry> entries_;
+  // evictable values with less than k accesses, ordered by first access
+  std::set<rank_t> infinite_;
+  // evictable values with k accesses, ordered by k-th most recent access
+  std::set<rank_t> finite_;
+};
+
+} // namespace scudb
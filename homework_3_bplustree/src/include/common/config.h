@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace scudb {
@@ -16,15 +17,42 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds PAGE_CLEANER_TIMEOUT;
+
+// size of a data page in byte, a power of two between MIN_PAGE_SIZE and
+// MAX_PAGE_SIZE. Only change it while no page is in memory: frames and page
+// layouts are sized with it
+extern size_t PAGE_SIZE;
+
+extern size_t BUFFER_POOL_SIZE; // frames of the storage engine buffer pool
+
+// back the frames of buffer pools created from now on with huge pages
+extern bool ENABLE_HUGE_PAGES;
+
+// b+ tree writers find their leaf with an optimistic descent, not by crabbing
+extern bool ENABLE_OPTIMISTIC_WRITES;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
+#define FREE_SPACE_MAP_PAGE_ID 1 // the first free space bitmap page id
+#define DEFAULT_PAGE_SIZE 512 // page size of a new database
+#define MIN_PAGE_SIZE 512
+#define MAX_PAGE_SIZE 16384
 #define LOG_BUFFER_SIZE                                                            \
-  ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
+  ((DEFAULT_BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
-#define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define DEFAULT_BUFFER_POOL_SIZE 10    // size of buffer pool
+#define LRUK_REPLACER_K 2              // history depth of LRU-K replacer
+#define PAGE_CLEANER_DIRTY_RATIO 0.1   // dirty frames page cleaner leaves
+#define IO_WORKER_NUM 2                // threads serving asynchronous I/O
+#define IO_QUEUE_DEPTH 64              // io_uring requests in flight
+#define SCAN_RING_SIZE 4               // frames recycled by a sequential scan
+#define STATS_SHARD_NUM 16             // buffer pool counter shards
+#define OPTIMISTIC_RETRY_NUM 3         // failed optimistic descents to crab
+#define FRAME_SLAB_CHUNK_SIZE (2 << 20) // largest frame memory mapping, 2MB
+#define DIRECT_IO_ALIGNMENT 512        // O_DIRECT buffer alignment
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
@@ -0,0 +1,42 @@
+/**
+ * epoch_manager.h
+ *
+ * Functionality: Lets latch free readers dereference memory that a writer may
+ * free. A reader brackets its reads with an EpochGuard. A writer first makes
+ * the memory unreachable, then calls EpochManager::Synchronize(), which waits
+ * until every reader that was inside a guard at that time has left it, then
+ * frees the memory.
+ *
+ * Each thread announces itself in a slot of its own, so entering and leaving
+ * a guard write no cache line shared with other threads. Readers must not
+ * block inside a guard on anything a synchronizing thread may hold.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace scudb {
+
+class EpochManager {
+public:
+  static void Enter();
+  static void Exit();
+  // wait until the threads inside a guard now have left it
+  static void Synchronize();
+
+private:
+  static std::atomic<uint64_t> global_epoch_;
+};
+
+class EpochGuard {
+public:
+  EpochGuard() { EpochManager::Enter(); }
+  ~EpochGuard() { EpochManager::Exit(); }
+
+  EpochGuard(const EpochGuard &) = delete;
+  EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+} // namespace scudb
@@ -0,0 +1,70 @@
+/**
+ * hybrid_latch.h
+ *
+ * Reader-Writer latch with an optimistic read mode, in a single 8-byte word:
+ *
+ *   bits  0-29  number of shared holders
+ *   bit     30  somebody is parked on this latch
+ *   bit     31  exclusively held, or a writer is waiting for the readers
+ *   bits 32-63  version, bumped by every WUnlock()
+ *
+ * Optimistic readers do not write the latch: TryReadOptimistic() returns the
+ * version, the reader reads the protected data, then Validate() tells whether
+ * a writer got in meanwhile, in which case what was read must be thrown away.
+ *
+ * As with RWMutex a waiting writer blocks new readers. Blocked threads spin
+ * for a while, then park on a condition variable of a global parking table
+ * picked by the address of the latch.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace scudb {
+class HybridLatch {
+  static const uint64_t SHARED_ONE = 1;
+  static const uint64_t SHARED_MASK = (uint64_t(1) << 30) - 1;
+  static const uint64_t PARKED = uint64_t(1) << 30;
+  static const uint64_t EXCLUSIVE = uint64_t(1) << 31;
+  static const uint64_t VERSION_ONE = uint64_t(1) << 32;
+  static const uint64_t VERSION_MASK = ~(VERSION_ONE - 1);
+
+public:
+  HybridLatch() : state_(0) {}
+
+  HybridLatch(const HybridLatch &) = delete;
+  HybridLatch &operator=(const HybridLatch &) = delete;
+
+  void WLock();
+  void WUnlock();
+  void RLock();
+  void RUnlock();
+
+  // version to Validate() against, false if exclusively held right now
+  inline bool TryReadOptimistic(uint64_t &version) const {
+    uint64_t state = state_.load(std::memory_order_acquire);
+    version = state & VERSION_MASK;
+    return (state & EXCLUSIVE) == 0;
+  }
+  // true if no writer latched since TryReadOptimistic() returned version
+  inline bool Validate(uint64_t version) const {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t state = state_.load(std::memory_order_relaxed);
+    return (state & (VERSION_MASK | EXCLUSIVE)) == version;
+  }
+
+private:
+  // wait until blocked(state_) is false, spinning first, then parked, and
+  // move state_ to next(state_)
+  template <typename Blocked, typename Next>
+  void Wait(Blocked blocked, Next next);
+  void Wake();
+
+  std::atomic<uint64_t> state_;
+};
+
+static_assert(sizeof(HybridLatch) == 8, "latch should fit in a word");
+
+} // namespace scudb
@@ -0,0 +1,54 @@
+/**
+ * async_io_engine.h
+ *
+ * Functionality: Asynchronous I/O for the disk manager. A request is a
+ * vectored read or write at an offset of a descriptor, Submit() returns as
+ * soon as it is queued and the callback gets the number of bytes transferred,
+ * or -errno, on a completion thread of the engine.
+ *
+ * Two engines. The io_uring one is driven with raw system calls, no library
+ * needed: requests go straight to the kernel, up to IO_QUEUE_DEPTH in flight,
+ * and a single thread reaps completions. Where the kernel has no io_uring, or
+ * does not let this process use it, IO_WORKER_NUM threads run preadv and
+ * pwritev. Create() picks the first one that works.
+ *
+ * Submit() blocks while the queue is full, so callbacks must not submit.
+ * Deleting an engine waits for the requests in flight.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+struct AsyncIORequest {
+  bool is_write = false;
+  int fd = -1;
+  off_t offset = 0;
+  // buffers stay valid until the callback, the vector is owned by the request
+  std::vector<struct iovec> iovs;
+  std::function<void(ssize_t)> callback;
+};
+
+class AsyncIOEngine {
+public:
+  virtual ~AsyncIOEngine() {}
+
+  virtual void Submit(std::unique_ptr<AsyncIORequest> request) = 0;
+  // "io_uring" or "thread_pool"
+  virtual const char *GetName() const = 0;
+
+  // io_uring if available and allowed, unless use_io_uring is false, else
+  // the thread pool
+  static AsyncIOEngine *Create(bool use_io_uring = true);
+};
+
+} // namespace scudb
@@ -5,31 +5,90 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * Pages are read and written with pread/pwritev on a raw descriptor, so
+ * threads do I/O in parallel without sharing a file position, and the file
+ * size is kept in memory instead of asked for on every read. A write is not
+ * flushed: durability comes from Sync(), which callers call once for a batch
+ * of writes.
+ *
+ * With direct_io, the descriptor is opened with O_DIRECT: pages skip the
+ * kernel page cache, the buffer pool is the only cache of the database. Page
+ * buffers should be aligned on DIRECT_IO_ALIGNMENT, as buffer pool frames
+ * are, others go through an aligned copy. If the file system refuses
+ * O_DIRECT, at open or on the first page I/O, the disk manager goes on with
+ * buffered I/O.
+ *
+ * With a free space map, see free_space_map.h, deallocated pages are
+ * allocated again. A reopened db file allocates from its end on.
+ *
+ * Asynchronous page I/O goes through an AsyncIOEngine, io_uring when the
+ * kernel allows it, so read-ahead and batched writes keep many requests in
+ * flight without a thread each.
  */
 
 #pragma once
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <future>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io_engine.h"
+#include "disk/free_space_map.h"
 
 namespace scudb {
 
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, bool direct_io = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
   void ReadPage(page_id_t page_id, char *page_data);
+  // write pages_data.size() consecutive pages starting at page_id at once
+  void WritePages(page_id_t page_id, const std::vector<const char *> &pages_data);
+  // fdatasync the db file: the pages written before are durable
+  void Sync();
+  // asynchronous I/O: queue the transfer on the I/O engine and return, the
+  // callback is called on a completion thread once it is done and must not
+  // queue more I/O. Buffers stay valid until then. Pending requests are all
+  // done when the disk manager is deleted
+  void ReadPageAsync(page_id_t page_id, char *page_data,
+                     std::function<void()> callback);
+  void WritePageAsync(page_id_t page_id, const char *page_data,
+                      std::function<void()> callback);
+  void WritePagesAsync(page_id_t page_id,
+                       const std::vector<const char *> &pages_data,
+                       std::function<void()> callback);
+  // "io_uring" or "thread_pool"
+  const char *GetIOEngineName();
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
   page_id_t AllocatePage();
   void DeallocatePage(page_id_t page_id);
+  // track freed pages in free_space_map, nullptr to stop. Its buffer pool
+  // must not call AllocatePage() or DeallocatePage() under a latch it takes
+  inline void SetFreeSpaceMap(FreeSpaceMap *free_space_map) {
+    free_space_map_ = free_space_map;
+  }
+
+  // pages in the db file, a partial last page counts
+  page_id_t GetNumPages();
+  // allocate from the end of the db file again, counted in pages of the
+  // current PAGE_SIZE. For a page size set after the disk manager was
+  // created, before any page is allocated
+  void ResetNextPageId();
+
+  inline bool IsDirectIO() const { return direct_io_; }
 
   int GetNumFlushes() const;
   bool GetFlushState() const;
@@ -37,17 +96,31 @@ public:
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
-  int GetFileSize(const std::string &name);
+  long long GetFileSize(const std::string &name);
+  // the I/O engine, created on the first asynchronous request
+  AsyncIOEngine *GetIOEngine();
+  // turn O_DIRECT off after an EINVAL, return true to retry the transfer
+  bool StopDirectIO();
+  // raise the cached file size to size if smaller
+  void GrowFileSize(long long size);
+  static bool IsAligned(const char *page_data);
+  static char *AllocateAligned(size_t size);
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // descriptor of the db file, and whether it is in O_DIRECT mode
+  int db_fd_ = -1;
+  std::atomic<bool> direct_io_{false};
   std::string file_name_;
+  std::atomic<long long> file_size_{0};
   std::atomic<page_id_t> next_page_id_;
+  std::atomic<FreeSpaceMap *> free_space_map_{nullptr};
   int num_flushes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  std::atomic<AsyncIOEngine *> io_engine_{nullptr};
+  std::mutex io_engine_latch_;
 };
 
 } // namespace scudb
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * free_space_map.h
+ *
+ * Functionality: Free space tracking of the db file. The disk manager hands
+ * the pages freed by DeallocatePage() out again from AllocatePage(), instead
+ * of growing the file for good.
+ *
+ * Freed pages are set bits of bitmap pages, which are pages of the db file
+ * fetched and written back through the buffer pool like any other. With
+ * bits = PAGE_SIZE * 8, bitmap page g is page 1 + g * (bits + 1) and its bit
+ * i stands for the page right after it plus i. The header page is never
+ * freed. A bitmap page comes before the pages it covers, so the pages of the
+ * file are all the pages ever allocated, and the disk manager starts a
+ * reopened file at its end.
+ *
+ * A page freed while every frame of the pool is pinned, so its bitmap page
+ * can not be fetched, is only remembered in memory until handed out again.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class BufferPoolManager;
+
+class FreeSpaceMap {
+public:
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  // take a freed page below end, the pages allocated so far, or return
+  // INVALID_PAGE_ID if there is none
+  page_id_t Allocate(page_id_t end);
+  void Deallocate(page_id_t page_id);
+  // bitmap pages are never allocated
+  bool IsBitmapPage(page_id_t page_id) const;
+
+private:
+  // bitmap page covering page_id, page_id itself for a bitmap page
+  page_id_t GetBitmapPageId(page_id_t page_id) const;
+
+  BufferPoolManager *buffer_pool_manager_;
+  const page_id_t bits_per_page_;
+  // no page below is free, except for unsaved_
+  page_id_t first_free_ = 0;
+  // freed pages not in a bitmap page
+  std::vector<page_id_t> unsaved_;
+  std::mutex latch_;
+};
+
+} // namespace scudb
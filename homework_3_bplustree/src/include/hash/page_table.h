@@ -0,0 +1,81 @@
+/*
+ * page_table.h : concurrent hash map from page id to frame, the page table of
+ * the buffer pool manager
+ *
+ * Functionality: Open addressing with linear probing over a power of two
+ * array of slots, each slot an atomic page id and an atomic frame pointer.
+ * INVALID_PAGE_ID marks empty slots, it is never found nor removed.
+ * Find() takes no lock: it loads the table, then the slots of the probe
+ * sequence. Insert() and Remove() are serialized by a writer mutex. Removal
+ * shifts the following entries of the probe sequence back instead of leaving
+ * tombstones, and the table doubles once it is half full: the new table is
+ * published with a single pointer store, old tables are kept until the page
+ * table is deleted since a reader may still be probing them.
+ *
+ * While writers are excluded (e.g. by the buffer pool latch) Find() is exact.
+ * A Find() racing with writers may miss a page that is present, or return a
+ * frame the page was mapped to a moment ago: lock-free callers must check the
+ * frame they get back.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+namespace scudb {
+
+class Page;
+
+class PageTable {
+public:
+  // room for at least capacity pages before the first resize
+  explicit PageTable(size_t capacity = BUFFER_POOL_SIZE);
+  ~PageTable();
+
+  // lookup and modifier
+  bool Find(page_id_t page_id, Page *&frame);
+  bool Remove(page_id_t page_id);
+  // false if page_id is mapped already, its frame is left in place
+  bool Insert(page_id_t page_id, Page *frame);
+
+  size_t GetSize();
+  size_t GetCapacity();
+
+private:
+  struct Slot {
+    std::atomic<page_id_t> page_id{INVALID_PAGE_ID};
+    std::atomic<Page *> frame{nullptr};
+  };
+  struct Table {
+    explicit Table(size_t num_slots);
+    ~Table() { delete[] slots; }
+    // home slot of page_id
+    inline size_t Home(page_id_t page_id) const {
+      // Fibonacci hashing, consecutive page ids spread over the table
+      return static_cast<size_t>((static_cast<uint32_t>(page_id) *
+                                  UINT64_C(11400714819323198485)) >>
+                                 shift);
+    }
+    Slot *slots;
+    size_t mask;  // number of slots - 1
+    int shift;    // 64 - log2(number of slots)
+  };
+
+  // double the table, caller holds write_latch_
+  void Grow();
+  // place an entry known to be absent, caller holds write_latch_
+  static void Place(Table *table, page_id_t page_id, Page *frame);
+  // (re)fill a slot so that readers never see page_id with another frame
+  static void Store(Slot &slot, page_id_t page_id, Page *frame);
+
+  std::atomic<Table *> table_;
+  std::vector<Table *> retired_; // replaced tables, readers may be in them
+  size_t size_ = 0;
+  std::mutex write_latch_;
+};
+
+} // namespace scudb
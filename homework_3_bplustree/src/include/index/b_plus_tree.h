@@ -7,9 +7,22 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency follows Lehman and Yao's B-link tree: a split moves the upper
+ * half of a page to a new right sibling, linked from the page with the high
+ * key in between, then releases the page and posts the separator to the
+ * parent on its own. Whoever reaches a page whose high key is not above its
+ * key, through a parent the separator is not in yet, moves right. Writers read
+ * latch their way down and write latch only the pages they change, one level
+ * at a time, so there is no tree wide latch. Merges and redistributions latch
+ * the parent and the two siblings top down, left to right, the same order as
+ * everyone else. The leaf a writer changes is usually found like a reader finds
+ * it, with no latch above the leaf, see ENABLE_OPTIMISTIC_WRITES.
  */
 #pragma once
 
+#include <atomic>
+#include <mutex>
 #include <queue>
 #include <vector>
 
@@ -33,6 +46,8 @@ public:
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
+  inline page_id_t GetRootPageId() const { return root_page_id_.load(); }
+
   // Insert a key-value pair into this B+ tree.
   bool Insert(const KeyType &key, const ValueType &value,
               Transaction *transaction = nullptr);
@@ -59,55 +74,70 @@ public:
   void RemoveFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
 
-  // expose for test purpose
-    BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *
-    FindLeafPage(const KeyType &key, bool leftMost = false,
-               Operation op = Operation::READONLY,
-               Transaction *transaction = nullptr);
-
 private:
+  // read only descent, returns the guard of the leaf
+  ReadPageGuard FindLeafPageRead(const KeyType &key, bool leftMost = false);
+  // walk the resident internal nodes down from page_id without latching them
+  bool FindLeafPageOptimistic(const KeyType &key, bool leftMost,
+                              page_id_t &page_id, Page *&parent,
+                              uint64_t &parent_version);
+  // latch crabbing from the page held by guard down to the leaf
+  ReadPageGuard CrabToLeaf(ReadPageGuard guard, const KeyType &key,
+                           bool leftMost);
+  // read latch crabbing from the root down to the page of level covering key,
+  // which is write latched. Invalid if the tree is empty or not that high
+  WritePageGuard FindPageWrite(const KeyType &key, int level);
+  // write latch the leaf covering key after an optimistic descent. Invalid if
+  // the descents keep failing validation, or stop above the leaf level
+  WritePageGuard FindLeafPageWriteOptimistic(const KeyType &key);
+  // follow the right links while key is not below the high key of the page
+  void MoveRight(ReadPageGuard &guard, const KeyType &key);
+  void MoveRight(WritePageGuard &guard, const KeyType &key);
+  // the right sibling holding key if node does not, else INVALID_PAGE_ID
+  page_id_t GetRightPageId(BPlusTreePage *node, const KeyType &key);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
-                      Transaction *transaction = nullptr);
+  bool InsertIntoLeaf(WritePageGuard guard, const KeyType &key,
+                      const ValueType &value);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
-                        BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  void InsertIntoParent(WritePageGuard old_guard, const KeyType &key,
+                        WritePageGuard new_guard);
 
-  template <typename N> N *Split(N *node);
+  template <typename N> WritePageGuard Split(N *node);
+
+  // rebalance the underfull page of level holding key, then its parents
+  void CoalesceOrRedistribute(const KeyType &key, int level);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(WritePageGuard &parent_guard,
+                              const KeyType &key);
 
+  // index: of right in parent
   template <typename N>
   void Coalesce(
-      N *&neighbor_node, N *&node,
-      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-      int index, Transaction *transaction = nullptr);
+      N *left, N *right,
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+      int index);
 
-  template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
+  template <typename N>
+  void Redistribute(
+      N *left, N *right,
+      BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+      int index, bool to_left);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  bool AdjustRoot(WritePageGuard &root_guard, WritePageGuard &child_guard);
 
   void UpdateRootPageId(int insert_record = false);
 
-    // unlock all parents
-    void UnlockUnpinPages(Operation op, Transaction *transaction);
-
-    template <typename N>
-    bool isSafe(N *node, Operation op);
-
-    inline void lockRoot() { mutex_.lock(); }
-    inline void unlockRoot() { mutex_.unlock(); }
-
   // member variable
-  std::mutex mutex_;                       // protect `root_page_id_` from concurrent modification
+  std::mutex mutex_; // serializes starting a tree, nothing else
   std::string index_name_;
-  page_id_t root_page_id_;
+  // changes with the latch of the old root held, whoever latched the root
+  // checks it still is
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
-  static thread_local bool root_is_locked; // root is locked?
 };
 
 } // namespace scudb
@@ -35,6 +35,9 @@ public:
                Transaction *transaction = nullptr) override;
 
 protected:
+  // the index key of a key tuple, normalized if the metadata says so
+  void SetIndexKey(KeyType &index_key, const Tuple &key) const;
+
   // comparator for key
   KeyComparator comparator_;
   // container
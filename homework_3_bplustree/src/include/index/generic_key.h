@@ -6,6 +6,14 @@
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * A key holds either the key tuple as is, compared column by column through
+ * the key schema, or its normalized form, compared with a single memcmp. The
+ * normalized form lays out the columns in key schema order: integers big
+ * endian with the sign bit flipped, decimals as their IEEE bits made to order
+ * as unsigned integers, varchars with 0x00 escaped as 0x00 0x01 and ended by
+ * 0x00 0x00. NULL integers and decimals are their smallest value, a NULL
+ * varchar is empty.
  */
 #pragma once
 
@@ -15,6 +23,11 @@
 #include "type/value.h"
 
 namespace scudb {
+// write the normalized form of the key tuple to data, cut at size bytes,
+// return its full length
+size_t NormalizeKey(const Tuple &tuple, Schema *key_schema, char *data,
+                    size_t size);
+
 template <size_t KeySize> class GenericKey {
 public:
   inline void SetFromKey(const Tuple &tuple) {
@@ -23,6 +36,13 @@ public:
     memcpy(data, tuple.GetData(), tuple.GetLength());
   }
 
+  // normalized form, for a comparator of normalized keys. Longer keys are
+  // cut, they compare equal if they only differ past KeySize
+  inline void SetFromKey(const Tuple &tuple, Schema *key_schema) {
+    memset(data, 0, KeySize);
+    NormalizeKey(tuple, key_schema, data, KeySize);
+  }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data, 0, KeySize);
@@ -67,6 +87,9 @@ template <size_t KeySize> class GenericComparator {
 public:
   inline int operator()(const GenericKey<KeySize> &lhs,
                         const GenericKey<KeySize> &rhs) const {
+    if (normalized_) {
+      return memcmp(lhs.data, rhs.data, KeySize);
+    }
     int column_count = key_schema_->GetColumnCount();
 
     for (int i = 0; i < column_count; i++) {
@@ -85,13 +108,32 @@ public:
 
   GenericComparator(const GenericComparator &other) {
     this->key_schema_ = other.key_schema_;
+    this->integer_key_type_ = other.integer_key_type_;
+    this->normalized_ = other.normalized_;
   }
 
-  // constructor
-  GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  // constructor, normalized: compare keys set from their normalized form
+  GenericComparator(Schema *key_schema, bool normalized = false)
+      : key_schema_(key_schema), normalized_(normalized) {
+    if (!normalized_ && key_schema_->GetColumnCount() == 1 && key_schema_->IsInlined(0) &&
+        key_schema_->GetOffset(0) == 0 &&
+        (key_schema_->GetType(0) == TypeId::INTEGER ||
+         key_schema_->GetType(0) == TypeId::BIGINT)) {
+      integer_key_type_ = key_schema_->GetType(0);
+    }
+  }
+
+  // INTEGER or BIGINT if the key is that single column, so the native value
+  // is at the start of the key and searches may compare it directly (NULL is
+  // the smallest value then), INVALID otherwise
+  inline TypeId GetIntegerKeyType() const { return integer_key_type_; }
+
+  inline bool IsNormalized() const { return normalized_; }
 
 private:
   Schema *key_schema_;
+  TypeId integer_key_type_ = TypeId::INVALID;
+  bool normalized_;
 };
 
 } // namespace scudb
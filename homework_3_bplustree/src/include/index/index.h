@@ -27,9 +27,13 @@ class IndexMetadata {
   IndexMetadata() = delete;
 
 public:
+  // normalized_keys: the index stores keys in their normalized form, see
+  // generic_key.h
   IndexMetadata(std::string index_name, std::string table_name,
-                const Schema *tuple_schema, const std::vector<int> &key_attrs)
-      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs) {
+                const Schema *tuple_schema, const std::vector<int> &key_attrs,
+                bool normalized_keys = false)
+      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs),
+        normalized_keys_(normalized_keys) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
   }
 
@@ -47,6 +51,8 @@ public:
   // because it uses the member of catalog::Schema which is not known here
   int GetIndexColumnCount() const { return (int)key_attrs_.size(); }
 
+  inline bool HasNormalizedKeys() const { return normalized_keys_; }
+
   //  Returns the mapping relation between indexed columns  and base table
   //  columns
   inline const std::vector<int> &GetKeyAttrs() const { return key_attrs_; }
@@ -69,6 +75,7 @@ private:
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<int> key_attrs_;
+  const bool normalized_keys_;
   // schema of the indexed key
   Schema *key_schema_;
 };
@@ -14,10 +14,9 @@ namespace scudb {
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
-  // you may define your own constructor based on your member variables
-  IndexIterator(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *,
-                int, BufferPoolManager *);
-  ~IndexIterator();
+  // the iterator keeps the guard of the current leaf, the leaf stays read
+  // latched and pinned until the iterator moves past it or is destroyed
+  IndexIterator(ReadPageGuard &&, int, BufferPoolManager *);
 
   bool isEnd();
 
@@ -26,7 +25,10 @@ public:
   IndexIterator &operator++();
 
 private:
+  void SkipToItem();
+
   // add your own private member variables here
+  ReadPageGuard guard_;
   BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *leaf_;
     int index_;
     BufferPoolManager *buff_pool_manager_;
@@ -0,0 +1,58 @@
+/**
+ * integer_key.h
+ *
+ * Key of an index on a single INTEGER or BIGINT column
+ *
+ * The key is the native integer, compared inline, instead of a GenericKey
+ * compared through the key schema. NULL is the smallest value of the type.
+ */
+#pragma once
+
+#include <cstring>
+
+#include "table/tuple.h"
+
+namespace scudb {
+template <typename IntType> class IntegerKey {
+public:
+  // the key tuple has the integer column only, at its start
+  inline void SetFromKey(const Tuple &tuple) {
+    memcpy(&value, tuple.GetData(), sizeof(IntType));
+  }
+
+  // native integers already compare in key order
+  inline void SetFromKey(const Tuple &tuple,
+                         __attribute__((unused)) Schema *key_schema) {
+    SetFromKey(tuple);
+  }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) {
+    value = static_cast<IntType>(key);
+  }
+
+  // NOTE: for test purpose only
+  inline int64_t ToString() const { return value; }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  IntType value;
+};
+
+template <typename IntType> class IntegerComparator {
+public:
+  inline int operator()(const IntegerKey<IntType> &lhs,
+                        const IntegerKey<IntType> &rhs) const {
+    return (lhs.value > rhs.value) - (lhs.value < rhs.value);
+  }
+
+  // same constructor as GenericComparator, the key schema is not needed
+  IntegerComparator(__attribute__((unused)) Schema *key_schema = nullptr,
+                    __attribute__((unused)) bool normalized = false) {}
+};
+
+} // namespace scudb
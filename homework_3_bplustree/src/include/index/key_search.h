@@ -0,0 +1,137 @@
+/**
+ * key_search.h
+ *
+ * Search of the sorted (key, value) pairs of a B+ tree page. Binary search
+ * with the key comparator, except for integer keys, IntegerKey or a
+ * GenericKey of a single integer column: their native values are compared,
+ * and once the range is down to
+ * KEY_SEARCH_WINDOW pairs, the keys below the searched one are counted with
+ * SIMD compares, AVX2 when the build targets it.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <utility>
+
+#include "index/generic_key.h"
+#include "index/integer_key.h"
+
+namespace scudb {
+
+#define KEY_SEARCH_WINDOW 16 // pairs counted instead of bisected
+
+// number of the n integers at base, stride bytes apart, less than key, or
+// less than or equal to it with or_equal
+int CountLess(const char *base, size_t stride, int n, int32_t key,
+              bool or_equal);
+int CountLess(const char *base, size_t stride, int n, int64_t key,
+              bool or_equal);
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+class KeySearch {
+public:
+  using MappingType = std::pair<KeyType, ValueType>;
+
+  // first index in [begin, end) whose key is not less than key, or greater
+  // than it with upper, end if there is none
+  static int Bound(const MappingType *array, int begin, int end,
+                   const KeyType &key, const KeyComparator &comparator,
+                   bool upper) {
+    while (begin < end) {
+      int mid = begin + (end - begin) / 2;
+      int cmp = comparator(array[mid].first, key);
+      if (cmp < 0 || (upper && cmp == 0)) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin;
+  }
+};
+
+template <size_t KeySize, typename ValueType>
+class KeySearch<GenericKey<KeySize>, ValueType, GenericComparator<KeySize>> {
+public:
+  using MappingType = std::pair<GenericKey<KeySize>, ValueType>;
+
+  static int Bound(const MappingType *array, int begin, int end,
+                   const GenericKey<KeySize> &key,
+                   const GenericComparator<KeySize> &comparator, bool upper) {
+    TypeId integer_key_type = comparator.GetIntegerKeyType();
+    if (integer_key_type == TypeId::INTEGER && KeySize >= sizeof(int32_t)) {
+      return IntegerBound<int32_t>(array, begin, end, key, upper);
+    }
+    if (integer_key_type == TypeId::BIGINT && KeySize >= sizeof(int64_t)) {
+      return IntegerBound<int64_t>(array, begin, end, key, upper);
+    }
+    return KeySearch<GenericKey<KeySize>, ValueType,
+                     ComparatorRef>::Bound(array, begin, end, key,
+                                           ComparatorRef{comparator}, upper);
+  }
+
+private:
+  // the generic search, without recursing into this specialization
+  struct ComparatorRef {
+    const GenericComparator<KeySize> &comparator;
+    inline int operator()(const GenericKey<KeySize> &lhs,
+                          const GenericKey<KeySize> &rhs) const {
+      return comparator(lhs, rhs);
+    }
+  };
+
+  template <typename IntType>
+  static int IntegerBound(const MappingType *array, int begin, int end,
+                          const GenericKey<KeySize> &key, bool upper) {
+    IntType value = ToInteger<IntType>(key);
+    while (end - begin > KEY_SEARCH_WINDOW) {
+      int mid = begin + (end - begin) / 2;
+      IntType mid_value = ToInteger<IntType>(array[mid].first);
+      if (mid_value < value || (upper && mid_value == value)) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin + CountLess(array[begin].first.data, sizeof(MappingType),
+                             end - begin, value, upper);
+  }
+
+  // only called when the integer fits, the copy is bounded for the others
+  template <typename IntType>
+  static inline IntType ToInteger(const GenericKey<KeySize> &key) {
+    IntType value = 0;
+    memcpy(&value, key.data,
+           sizeof(IntType) < KeySize ? sizeof(IntType) : KeySize);
+    return value;
+  }
+};
+
+template <typename IntType, typename ValueType>
+class KeySearch<IntegerKey<IntType>, ValueType, IntegerComparator<IntType>> {
+public:
+  using MappingType = std::pair<IntegerKey<IntType>, ValueType>;
+
+  static int Bound(const MappingType *array, int begin, int end,
+                   const IntegerKey<IntType> &key,
+                   __attribute__((unused))
+                   const IntegerComparator<IntType> &comparator,
+                   bool upper) {
+    while (end - begin > KEY_SEARCH_WINDOW) {
+      int mid = begin + (end - begin) / 2;
+      if (array[mid].first.value < key.value ||
+          (upper && array[mid].first.value == key.value)) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return begin + CountLess(reinterpret_cast<const char *>(
+                                 &array[begin].first.value),
+                             sizeof(MappingType), end - begin, key.value,
+                             upper);
+  }
+};
+
+} // namespace scudb
@@ -12,6 +12,11 @@
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ * The header ends with NextPageId (4) and HighKey. Keys of the subtree are
+ * below HighKey, larger ones moved to the right sibling NextPageId by a split
+ * that may not be in the parent yet. The right most page of a level has no
+ * sibling and no upper bound.
  */
 
 #pragma once
@@ -31,7 +36,12 @@ INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
 public:
   // must call initialize method after "create" a new node
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id, int level = 1);
+
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
@@ -40,36 +50,43 @@ public:
   void SetValueAt(int index, const ValueType &value);
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+  // index of the child Lookup() returns
+  int LookupIndex(const KeyType &key, const KeyComparator &comparator) const;
+  // Lookup() for an optimistic reader, the page may change underneath: the
+  // size is read once and kept within the page, nothing is asserted. index is
+  // set to the slot of the value returned
+  ValueType LookupOptimistic(const KeyType &key,
+                             const KeyComparator &comparator,
+                             int &index) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
-  int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
-                      const ValueType &new_value);
+  // insert the new child new_value, on the right of the child holding new_key
+  int Insert(const KeyType &new_key, const ValueType &new_value,
+             const KeyComparator &comparator);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
-  void MoveHalfTo(BPlusTreeInternalPage *recipient,
-                  BufferPoolManager *buffer_pool_manager);
-  void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
-                 BufferPoolManager *buffer_pool_manager);
+  // recipient is the right sibling of this page in all of them but
+  // MoveAllTo() and MoveFirstToEndOf(), middle_key is the separator of the
+  // two in the parent. Afterwards the separator is KeyAt(0) of the right one
+  void MoveHalfTo(BPlusTreeInternalPage *recipient);
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
   void MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
+                        const KeyType &middle_key);
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient,
-                         int parent_index,
-                         BufferPoolManager *buffer_pool_manager);
+                         const KeyType &middle_key);
   // DEUBG and PRINT
   std::string ToString(bool verbose) const;
   void QueueUpChildren(std::queue<BPlusTreePage *> *queue,
                        BufferPoolManager *buffer_pool_manager);
 
 private:
-  void CopyHalfFrom(MappingType *items, int size,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyAllFrom(MappingType *items, int size,
-                   BufferPoolManager *buffer_pool_manager);
-  void CopyLastFrom(const MappingType &pair,
-                    BufferPoolManager *buffer_pool_manager);
-  void CopyFirstFrom(const MappingType &pair, int parent_index,
-                     BufferPoolManager *buffer_pool_manager);
+  void CopyHalfFrom(MappingType *items, int size);
+  void CopyAllFrom(MappingType *items, int size);
+  void CopyLastFrom(const MappingType &pair);
+  void CopyFirstFrom(const MappingType &pair);
+  page_id_t next_page_id_;
+  KeyType high_key_;
   MappingType array[0];
 };
 } // namespace scudb
@@ -10,13 +10,16 @@
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 28 bytes and the high key):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) | Level (4) |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  ------------------------------------------
+ * | PageId (4) | NextPageId (4) | HighKey
+ *  ------------------------------------------
+ *
+ * Keys of the page are below HighKey, the larger ones are in the right
+ * sibling NextPageId, see b_plus_tree_internal_page.h
  */
 #pragma once
 #include <utility>
@@ -34,10 +37,12 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 public:
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
-  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  void Init(page_id_t page_id);
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
   const MappingType &GetItem(int index);
@@ -49,15 +54,14 @@ public:
               const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key,
                             const KeyComparator &comparator);
-  // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient,
-                  BufferPoolManager *buffer_pool_manager /* Unused */);
-  void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
-                 BufferPoolManager * /* Unused */);
+  // Split and Merge utility methods, as in the internal page: afterwards the
+  // separator of the two siblings is KeyAt(0) of the right one
+  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  void MoveAllTo(BPlusTreeLeafPage *recipient, const KeyType & /* Unused */);
   void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
-                        BufferPoolManager *buffer_pool_manager);
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
-                         BufferPoolManager *buffer_pool_manager);
+                        const KeyType & /* Unused */);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient,
+                         const KeyType & /* Unused */);
   // Debug
   std::string ToString(bool verbose = false) const;
 
@@ -65,9 +69,9 @@ private:
   void CopyHalfFrom(MappingType *items, int size);
   void CopyAllFrom(MappingType *items, int size);
   void CopyLastFrom(const MappingType &item);
-  void CopyFirstFrom(const MappingType &item, int parentIndex,
-                     BufferPoolManager *buffer_pool_manager);
+  void CopyFirstFrom(const MappingType &item);
   page_id_t next_page_id_;
+  KeyType high_key_;
   MappingType array[0];
 };
 } // namespace scudb
@@ -10,8 +10,13 @@
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | Level (4) | PageId(4) |
  * ----------------------------------------------------------------------------
+ *
+ * Pages form a B-link tree: every page also links to its right sibling on the
+ * same level and keeps the high key, the separator between the two, see the
+ * leaf and internal page headers. Leaves are at level 0. There are no parent
+ * pointers, a writer finds the parent of a page by descending again.
  */
 
 #pragma once
@@ -23,6 +28,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "index/generic_key.h"
+#include "index/integer_key.h"
 
 namespace scudb {
 
@@ -38,7 +44,6 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE, ROO
 class BPlusTreePage {
 public:
   bool IsLeafPage() const;
-  bool IsRootPage() const;
   void SetPageType(IndexPageType page_type);
 
   int GetSize() const;
@@ -49,8 +54,8 @@ public:
   void SetMaxSize(int max_size);
   int GetMinSize() const;
 
-  page_id_t GetParentPageId() const;
-  void SetParentPageId(page_id_t parent_page_id);
+  int GetLevel() const;
+  void SetLevel(int level);
 
   page_id_t GetPageId() const;
   void SetPageId(page_id_t page_id);
@@ -63,7 +68,7 @@ private:
   lsn_t lsn_;
   int size_;
   int max_size_;
-  page_id_t parent_page_id_;
+  int level_;
   page_id_t page_id_;
 };
 
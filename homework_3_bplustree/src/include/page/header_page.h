@@ -2,13 +2,18 @@
  * header_page.h
  *
  * Database use the first page (page_id = 0) as header page to store metadata, in
- * our case, we will contain information about table/index name (length less than
- * 32 bytes) and their corresponding root_id
+ * our case, we will contain the page size and buffer pool size the database
+ * runs with, the features its file layout was created with, and information
+ * about table/index name (length less than 32 bytes) and their corresponding
+ * root_id. Flags were the upper half of the page size field, they are all
+ * clear in a database created before them.
  *
  * Format (size in byte):
- *  -----------------------------------------------------------------
- * | RecordCount (4) | Entry_1 name (32) | Entry_1 root_id (4) | ... |
- *  -----------------------------------------------------------------
+ *  ------------------------------------------------------------------------
+ * | PageSize (2) | Flags (2) | PoolSize (4) | RecordCount (4) |
+ *  ------------------------------------------------------------------------
+ * | Entry_1 name (32) | Entry_1 root_id (4) | ... |
+ *  ------------------------------------------------------------------------
  */
 
 #pragma once
@@ -21,7 +26,32 @@ namespace scudb {
 
 class HeaderPage : public Page {
 public:
-  void Init() { SetRecordCount(0); }
+  // the db file reserves the bitmap pages of a FreeSpaceMap
+  static const uint16_t FREE_SPACE_MAP = 0x1;
+  // index pages have a high key and a right sibling link (B-link tree)
+  static const uint16_t BLINK_PAGES = 0x2;
+
+  void Init(uint16_t flags = 0) {
+    SetPageSize(PAGE_SIZE);
+    SetFlags(flags);
+    SetPoolSize(BUFFER_POOL_SIZE);
+    SetRecordCount(0);
+  }
+  /**
+   * Database configuration related
+   */
+  size_t GetPageSize();
+  void SetPageSize(size_t page_size);
+  size_t GetPoolSize();
+  void SetPoolSize(size_t pool_size);
+  uint16_t GetFlags();
+  void SetFlags(uint16_t flags);
+  // same, from header page data read straight from disk, when the page size
+  // is not known yet. 0 for a database that was never initialized
+  static size_t GetPageSize(const char *data);
+  static size_t GetPoolSize(const char *data);
+  static uint16_t GetFlags(const char *data);
+
   /**
    * Record related
    */
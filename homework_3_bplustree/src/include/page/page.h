@@ -8,11 +8,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <iostream>
 
 #include "common/config.h"
-#include "common/rwmutex.h"
+#include "common/hybrid_latch.h"
 
 namespace scudb {
 
@@ -20,19 +22,66 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
-  ~Page(){};
+  // a page of its own, outside of any buffer pool
+  Page() : data_(new char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
+  // a frame, data is PAGE_SIZE bytes of the buffer pool, see FrameSlab
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+    delete[] swizzled_.load();
+  };
   // get actual data page content
   inline char *GetData() { return data_; }
   // get page id
   inline page_id_t GetPageId() { return page_id_; }
-  // get page pin count
-  inline int GetPinCount() { return pin_count_; }
+  // get page pin count, a free frame is not pinned
+  inline int GetPinCount() {
+    int pin_count = pin_count_;
+    return pin_count < 0 ? 0 : pin_count;
+  }
   // method use to latch/unlatch page content
   inline void WUnlatch() { rwlatch_.WUnlock(); }
   inline void WLatch() { rwlatch_.WLock(); }
   inline void RUnlatch() { rwlatch_.RUnlock(); }
   inline void RLatch() { rwlatch_.RLock(); }
+  // optimistic read: no latch is taken, what was read between the two calls
+  // is only valid if ValidateLatch() returns true
+  inline bool TryRLatchOptimistic(uint64_t &version) const {
+    return rwlatch_.TryReadOptimistic(version);
+  }
+  inline bool ValidateLatch(uint64_t version) const {
+    return rwlatch_.Validate(version);
+  }
+
+  // swizzled child references of a B+ tree internal page, kept in the frame
+  // and never in the page content: the frame that held the child of slot i
+  // when it was last followed. Whoever follows one checks the frame still
+  // holds that child, see BufferPoolManager::FetchPageOptimistic()
+  inline Page *GetSwizzled(int slot) const {
+    std::atomic<Page *> *swizzled = swizzled_.load(std::memory_order_acquire);
+    if (swizzled == nullptr || slot < 0 || slot >= GetSwizzleCapacity()) {
+      return nullptr;
+    }
+    return swizzled[slot].load(std::memory_order_relaxed);
+  }
+  inline void Swizzle(int slot, Page *child) {
+    if (slot < 0 || slot >= GetSwizzleCapacity()) {
+      return;
+    }
+    std::atomic<Page *> *swizzled = swizzled_.load(std::memory_order_acquire);
+    if (swizzled == nullptr) {
+      // first swizzle of this frame, racing threads agree on one array
+      auto *fresh = new std::atomic<Page *>[GetSwizzleCapacity()]();
+      if (swizzled_.compare_exchange_strong(swizzled, fresh)) {
+        swizzled = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    swizzled[slot].store(child, std::memory_order_relaxed);
+  }
 
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + 4); }
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + 4, &lsn, 4); }
@@ -40,12 +89,42 @@ public:
 private:
   // method used by buffer pool manager
   inline void ResetMemory() { memset(data_, 0, PAGE_SIZE); }
+  // drop the swizzled references when the frame changes hands
+  inline void Unswizzle() {
+    std::atomic<Page *> *swizzled = swizzled_.load(std::memory_order_relaxed);
+    if (swizzled != nullptr) {
+      for (int slot = 0; slot < GetSwizzleCapacity(); ++slot) {
+        swizzled[slot].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+  }
+  // an internal page entry takes at least 8 bytes, a 4 byte key and a page id
+  static inline int GetSwizzleCapacity() {
+    return static_cast<int>(PAGE_SIZE / 8);
+  }
   // members
-  char data_[PAGE_SIZE]; // actual data
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  int pin_count_ = 0;
-  bool is_dirty_ = false;
-  RWMutex rwlatch_;
+  char *data_; // actual data, PAGE_SIZE bytes
+  bool owns_data_ = false;
+  // page_id_, pin_count_ and io_in_progress_ change under the latch of the
+  // owning buffer pool manager, but are atomic: a page table hit pins a
+  // resident page without that latch. Unpinning a frame that keeps other
+  // pins only touches pin_count_ and is_dirty_, without that latch either.
+  // pin_count_ is -1 while the frame holds no page that may be pinned: free,
+  // or claimed by the buffer pool manager to be replaced or freed
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  std::atomic<int> pin_count_{-1};
+  std::atomic<bool> is_dirty_{false};
+  // pins by page table hits that bypassed the replacer, handed to it on the
+  // last unpin
+  std::atomic<uint32_t> hits_{0};
+  bool delete_on_unpin_ = false; // deleted while pinned, freed on last unpin
+  HybridLatch rwlatch_;
+  // frame I/O state
+  std::atomic<bool> io_in_progress_{false}; // content of page_id_ not loaded
+  page_id_t evicted_page_id_ = INVALID_PAGE_ID; // page being written back
+  bool evicted_dirty_ = false; // or only handed to the victim cache
+  std::atomic<std::atomic<Page *> *> swizzled_{nullptr}; // allocated on demand
+  std::condition_variable io_cv_; // notified when the I/O state changes
 };
 
 } // namespace scudb
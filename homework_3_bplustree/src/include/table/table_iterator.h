@@ -7,7 +7,9 @@
 #pragma once
 
 #include <cassert>
+#include <memory>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "table/tuple.h"
 
@@ -19,7 +21,9 @@ class TableIterator {
   friend class Cursor;
 
 public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  // pages are fetched through strategy when one is given
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
 
   ~TableIterator() { delete tuple_; }
 
@@ -43,6 +47,8 @@ private:
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  // frame ring of the scan, shared by the copies of the iterator
+  std::shared_ptr<BufferAccessStrategy> strategy_;
 };
 
 } // namespace scudb
\ No newline at end of file
@@ -4,11 +4,16 @@
 
 #pragma once
 
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
 #include "buffer/lru_replacer.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
 #include "logging/log_manager.h"
+#include "page/header_page.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
 #include "table/tuple.h"
@@ -59,20 +64,80 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+/* scudb_buffer_stats: read only, eponymous table over the storage engine
+ * buffer pool stats, one (name, value) row per metric */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr);
+
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
+
+int StatsDisconnect(sqlite3_vtab *pVtab);
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
+
+int StatsClose(sqlite3_vtab_cursor *cur);
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv);
+
+int StatsNext(sqlite3_vtab_cursor *cur);
+
+int StatsEof(sqlite3_vtab_cursor *cur);
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i);
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid);
+
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  // page_size and pool_size set PAGE_SIZE and BUFFER_POOL_SIZE, 0 means the
+  // default. An existing database keeps the page size stored in its header
+  // page, and its pool size unless pool_size is given. direct_io bypasses
+  // the kernel page cache. Freed pages are reused in a new database, and in
+  // one whose header page says it was created so. The same goes for indexes,
+  // which are only read in the B-link page layout
+  StorageEngine(std::string db_file_name, size_t page_size = 0,
+                size_t pool_size = 0, bool direct_io = false) {
     ENABLE_LOGGING = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, direct_io);
+    // frames are sized with the page size, read the header page before
+    std::vector<char> header(MAX_PAGE_SIZE);
+    disk_manager_->ReadPage(HEADER_PAGE_ID, header.data());
+    free_space_map_ = disk_manager_->GetNumPages() == 0;
+    blink_pages_ = disk_manager_->GetNumPages() == 0;
+    if (IsValidPageSize(HeaderPage::GetPageSize(header.data()))) {
+      page_size = HeaderPage::GetPageSize(header.data());
+      if (pool_size == 0) {
+        pool_size = HeaderPage::GetPoolSize(header.data());
+      }
+      // an older file has pages of its own where the bitmap pages would be
+      free_space_map_ = (HeaderPage::GetFlags(header.data()) &
+                         HeaderPage::FREE_SPACE_MAP) != 0;
+      // and its index pages may be of before the B-link layout
+      blink_pages_ = (HeaderPage::GetFlags(header.data()) &
+                      HeaderPage::BLINK_PAGES) != 0;
+    }
+    PAGE_SIZE = page_size != 0 ? page_size : DEFAULT_PAGE_SIZE;
+    BUFFER_POOL_SIZE = pool_size != 0 ? pool_size : DEFAULT_BUFFER_POOL_SIZE;
+    // the disk manager counted the pages of the file in the page size before
+    disk_manager_->ResetNextPageId();
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ =
         new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    // pages of dropped index nodes are reused
+    if (free_space_map_) {
+      buffer_pool_manager_->EnableFreeSpaceMap();
+    }
+    // the warm-up file is next to the log file, db file name with .warm
+    warm_up_file_name_ =
+        db_file_name.substr(0, db_file_name.find(".")) + ".warm";
+    WarmUp();
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,18 +147,62 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    SaveResidentPages();
+    buffer_pool_manager_->FlushAllPages();
     delete buffer_pool_manager_;
+    delete disk_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
   }
 
+  // a power of two between MIN_PAGE_SIZE and MAX_PAGE_SIZE
+  static bool IsValidPageSize(size_t page_size) {
+    return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+           (page_size & (page_size - 1)) == 0;
+  }
+
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
+  // the db file is laid out with free space bitmap pages
+  bool free_space_map_;
+  // index pages of the db file are in the B-link layout
+  bool blink_pages_;
+
+private:
+  // the warm-up file lists the resident page ids, hottest first, as saved by
+  // the last clean shutdown. It is removed once read: after a crash the pool
+  // starts cold rather than from a stale list. Pages the db file does not
+  // have (it was replaced) are left out
+  void WarmUp() {
+    std::ifstream file(warm_up_file_name_, std::ios::binary);
+    if (!file.is_open()) {
+      return;
+    }
+    std::vector<page_id_t> page_ids;
+    page_id_t num_pages = disk_manager_->GetNumPages();
+    page_id_t page_id;
+    while (file.read(reinterpret_cast<char *>(&page_id), sizeof(page_id))) {
+      if (page_id >= 0 && page_id < num_pages) {
+        page_ids.push_back(page_id);
+      }
+    }
+    file.close();
+    remove(warm_up_file_name_.c_str());
+    buffer_pool_manager_->WarmUp(page_ids);
+  }
+
+  void SaveResidentPages() {
+    std::vector<page_id_t> page_ids = buffer_pool_manager_->GetResidentPages();
+    std::ofstream file(warm_up_file_name_, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(page_ids.data()),
+               page_ids.size() * sizeof(page_id_t));
+  }
+
+  std::string warm_up_file_name_;
 };
 
 StorageEngine *storage_engine_;
@@ -264,4 +373,51 @@ private:
   VirtualTable *virtual_table_;
 }; // namespace scudb
 
+class StatsCursor {
+public:
+  // pool size and memory held, one row per counter, then the hit ratio, then
+  // count, mean, median and 99th percentile of each latency histogram
+  void Load(const BufferPoolStats &stats, size_t pool_size,
+            size_t memory_bytes);
+
+  inline void Clear() {
+    rows_.clear();
+    offset_ = 0;
+  }
+
+  inline bool isEof() { return offset_ == rows_.size(); }
+
+  inline void Next() { ++offset_; }
+
+  inline size_t GetOffset() { return offset_; }
+
+  inline const std::string &GetName() { return rows_[offset_].name; }
+
+  // counters are integers, ratios and means are real
+  inline bool IsReal() { return rows_[offset_].is_real; }
+
+  inline sqlite3_int64 GetIntValue() { return rows_[offset_].int_value; }
+
+  inline double GetRealValue() { return rows_[offset_].real_value; }
+
+private:
+  struct Row {
+    std::string name;
+    bool is_real;
+    sqlite3_int64 int_value;
+    double real_value;
+  };
+
+  inline void AddRow(const std::string &name, uint64_t value) {
+    rows_.push_back({name, false, static_cast<sqlite3_int64>(value), 0});
+  }
+  inline void AddRow(const std::string &name, double value) {
+    rows_.push_back({name, true, 0, value});
+  }
+
+  sqlite3_vtab_cursor base_; /* Base class - must be first */
+  std::vector<Row> rows_;
+  size_t offset_ = 0;
+};
+
 } // namespace scudb
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <string>
 
+#include "common/epoch_manager.h"
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/rid.h"
@@ -23,10 +24,6 @@ BPLUSTREE_TYPE::BPlusTree(const std::string &name,
 /*
  * Helper function to decide whether current b+tree is empty
  */
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-thread_local bool BPlusTree<KeyType, ValueType, KeyComparator>::root_is_locked = false;
-
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::IsEmpty() const {
     return root_page_id_ == INVALID_PAGE_ID;
@@ -46,27 +43,17 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
     // for debug
     //__attribute__((unused)) auto checker = Checker{buffer_pool_manager_};
 
-    auto *leaf = FindLeafPage(key, false, Operation::READONLY, transaction);
-    bool ret = false;
-    if (leaf != nullptr) {
-        ValueType value;
-        if (leaf->Lookup(key, value, comparator_)) {
-            result.push_back(value);
-            ret = true;
-        }
-        UnlockUnpinPages(Operation::READONLY, transaction);
-
-        // in case of `transaction` is nullptr
-        if (transaction == nullptr) {
-            auto page_id = leaf->GetPageId();
-            // unlock and unpin
-            buffer_pool_manager_->FetchPage(page_id)->RUnlatch();
-            buffer_pool_manager_->UnpinPage(page_id, false);
-            // unpin again
-            buffer_pool_manager_->UnpinPage(page_id, false);
-        }
+    ReadPageGuard guard = FindLeafPageRead(key);
+    if (!guard.IsValid()) {
+        return false;
+    }
+    auto *leaf = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    ValueType value;
+    if (leaf->Lookup(key, value, comparator_)) {
+        result.push_back(value);
+        return true;
     }
-    return ret;
+    return false;
 }
 
 /*****************************************************************************
@@ -85,16 +72,20 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
     // for debug
     //__attribute__((unused)) auto checker = Checker{buffer_pool_manager_};
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
+    while (true) {
         if (IsEmpty()) {
-            //std::cerr << "thread: " << transaction->GetThreadId()
-            //          << ", insert key: " << key << std::endl;
-            StartNewTree(key, value);
-            return true;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (IsEmpty()) {
+                StartNewTree(key, value);
+                return true;
+            }
+        }
+        // the tree may have been emptied since
+        WritePageGuard guard = FindPageWrite(key, 0);
+        if (guard.IsValid()) {
+            return InsertIntoLeaf(std::move(guard), key, value);
         }
     }
-    return InsertIntoLeaf(key, value, transaction);
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -104,224 +95,157 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
-    auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-    if (page == nullptr) {
+    page_id_t page_id;
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    if (!guard.IsValid()) {
         throw Exception(EXCEPTION_TYPE_INDEX,
                         "all page are pinned while StartNewTree");
     }
-    auto root =
-            reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType,
-            KeyComparator> *>(page->GetData());
-    UpdateRootPageId(true);
-    root->Init(root_page_id_, INVALID_PAGE_ID);
+    auto root = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    root->Init(page_id);
     root->Insert(key, value, comparator_);
 
-    // unpin root
-    buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
+    // publish the root once it is filled in
+    root_page_id_ = page_id;
+    UpdateRootPageId(true);
 }
 
 /*
  * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immdiately, otherwise insert entry. Remember to deal with split if necessary.
+ * guard holds the leaf covering key. Look through leaf page to see whether
+ * insert key exist or not. If exist, return immdiately, otherwise insert
+ * entry. Remember to deal with split if necessary.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
-                                    Transaction *transaction) {
-    // find the leaf node
-    auto *leaf = FindLeafPage(key, false, Operation::INSERT, transaction);
-    if (leaf == nullptr) {
-        return false;
-    }
+bool BPLUSTREE_TYPE::InsertIntoLeaf(WritePageGuard guard, const KeyType &key,
+                                    const ValueType &value) {
+    auto *leaf = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
 
     // if already in the tree, return false
     ValueType v;
     if (leaf->Lookup(key, v, comparator_)) {
-        //std::cerr << "thread: " << transaction->GetThreadId() << ", key: " << key
-        //          << " already exists" << std::endl;
-        UnlockUnpinPages(Operation::INSERT, transaction);
         return false;
     }
 
-    //std::cerr << "thread: " << transaction->GetThreadId()
-    //          << ", insert key: " << key << std::endl;
-
+    guard.SetDirty();
     if (leaf->GetSize() < leaf->GetMaxSize()) {
         leaf->Insert(key, value, comparator_);
-    } else {
-        // when leaf node can hold even number of key-value pairs
-        // the following method is ok, but if the leaf node can hold
-        // odd number of pairs, the following split method may uneven
-        // one child may have two more pairs than the other which should
-        // be equal.
-        auto *leaf2 = Split<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>(leaf);
-        if (comparator_(key, leaf2->KeyAt(0)) < 0) {
-            leaf->Insert(key, value, comparator_);
-        } else {
-            leaf2->Insert(key, value, comparator_);
-        }
+        return true;
+    }
 
-        // chain together
-        if (comparator_(leaf->KeyAt(0), leaf2->KeyAt(0)) < 0) {
-            leaf2->SetNextPageId(leaf->GetNextPageId());
-            leaf->SetNextPageId(leaf2->GetPageId());
-        } else {
-            leaf2->SetNextPageId(leaf->GetPageId());
-        }
-        // insert the split key into parent
-        InsertIntoParent(leaf, leaf2->KeyAt(0), leaf2, transaction);
+    // split first, then insert into the half covering key
+    WritePageGuard new_guard =
+            Split<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>(leaf);
+    auto *leaf2 =
+            new_guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    if (comparator_(key, leaf2->KeyAt(0)) < 0) {
+        leaf->Insert(key, value, comparator_);
+    } else {
+        leaf2->Insert(key, value, comparator_);
     }
 
-    UnlockUnpinPages(Operation::INSERT, transaction);
+    // insert the split key into parent
+    InsertIntoParent(std::move(guard), leaf2->KeyAt(0), std::move(new_guard));
     return true;
 }
 
 /*
- * Split input page and return newly created page.
+ * Split input page and return the guard of the newly created page.
  * Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * of key & value pairs from input page to newly created page, which becomes
+ * its right sibling. Nobody reaches the new page before node is released
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) {
+template <typename N> WritePageGuard BPLUSTREE_TYPE::Split(N *node) {
     page_id_t page_id;
-    auto *page = buffer_pool_manager_->NewPage(page_id);
-    if (page == nullptr) {
+    WritePageGuard guard = buffer_pool_manager_->NewPageGuarded(page_id);
+    if (!guard.IsValid()) {
         throw Exception(EXCEPTION_TYPE_INDEX,
                         "all page are pinned while Split");
     }
-    auto new_node = reinterpret_cast<N *>(page->GetData());
+    auto new_node = guard.template As<N>();
     new_node->Init(page_id);
+    new_node->SetLevel(node->GetLevel());
 
-    node->MoveHalfTo(new_node, buffer_pool_manager_);
-    return new_node;
+    node->MoveHalfTo(new_node);
+    return guard;
 }
 
 /*
  * Insert key & value pair into internal page after split
- * @param   old_node      input page from split() method
- * @param   key
- * @param   new_node      returned page from split() method
- * User needs to first find the parent page of old_node, parent node must be
- * adjusted to take info of new_node into account. Remember to deal with split
- * recursively if necessary.
+ * @param   old_guard     latch of the page that was split
+ * @param   key           separator, first key of the new page
+ * @param   new_guard     latch of the new page returned from split() method
+ * The new page is reachable through the right link of the old one, so both
+ * are released before the parent is write latched, going down again from the
+ * root. Remember to deal with split recursively if necessary.
+ * Only the split of the root keeps it latched until the new root is in place:
+ * a page at the next level must exist before the new page can split again.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
+void BPLUSTREE_TYPE::InsertIntoParent(WritePageGuard old_guard,
                                       const KeyType &key,
-                                      BPlusTreePage *new_node,
-                                      Transaction *transaction) {
-    if (old_node->IsRootPage()) {
-        auto *page = buffer_pool_manager_->NewPage(root_page_id_);
-        if (page == nullptr) {
-            throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while InsertIntoParent");
+                                      WritePageGuard new_guard) {
+    KeyType separator = key;
+    while (true) {
+        int level = old_guard.As<BPlusTreePage>()->GetLevel();
+        if (old_guard.GetPageId() == root_page_id_) {
+            page_id_t page_id;
+            WritePageGuard root_guard =
+                    buffer_pool_manager_->NewPageGuarded(page_id);
+            if (!root_guard.IsValid()) {
+                throw Exception(EXCEPTION_TYPE_INDEX,
+                                "all page are pinned while InsertIntoParent");
+            }
+            auto root = root_guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+                    KeyComparator>>();
+            root->Init(page_id, level + 1);
+            root->PopulateNewRoot(old_guard.GetPageId(), separator,
+                                  new_guard.GetPageId());
+
+            // update to new 'root_page_id'
+            root_page_id_ = page_id;
+            UpdateRootPageId(false);
+            return;
         }
-        assert(page->GetPinCount() == 1);
-        auto root =
-                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                KeyComparator> *>(page->GetData());
-        root->Init(root_page_id_);
-        root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
-
-        old_node->SetParentPageId(root_page_id_);
-        new_node->SetParentPageId(root_page_id_);
-
-        // update to new 'root_page_id'
-        UpdateRootPageId(false);
 
-        buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
+        page_id_t new_page_id = new_guard.GetPageId();
+        new_guard.Release();
+        old_guard.Release();
 
-        // parent is done
-        buffer_pool_manager_->UnpinPage(root->GetPageId(), true);
-
-    } else {
-        auto *page = buffer_pool_manager_->FetchPage(old_node->GetParentPageId());
-        if (page == nullptr) {
+        WritePageGuard guard = FindPageWrite(separator, level + 1);
+        if (!guard.IsValid()) {
             throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while InsertIntoParent");
+                            "no parent level while InsertIntoParent");
         }
-        auto internal =
-                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                KeyComparator> *>(page->GetData());
+        guard.SetDirty();
+        auto internal = guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+                KeyComparator>>();
         // internal node have space to take new pair
         if (internal->GetSize() < internal->GetMaxSize()) {
-            internal->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-            // set ParentPageID
-            new_node->SetParentPageId(internal->GetPageId());
+            internal->Insert(separator, new_page_id, comparator_);
+            return;
+        }
 
-            // new_node is split from old_node, must be dirty
-            buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
+        // internal have no space and have to split, the pair goes into the
+        // half covering its key
+        new_guard = Split<BPlusTreeInternalPage<KeyType, page_id_t,
+                KeyComparator>>(internal);
+        auto internal2 = new_guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+                KeyComparator>>();
+        if (comparator_(separator, internal2->KeyAt(0)) < 0) {
+            internal->Insert(separator, new_page_id, comparator_);
         } else {
-            // internal have no space and have to split
-            // first make a copy of internal node, simplify split process
-            page_id_t page_id;
-            auto *page = buffer_pool_manager_->NewPage(page_id);
-            if (page == nullptr) {
-                throw Exception(EXCEPTION_TYPE_INDEX,
-                                "all page are pinned while InsertIntoParent");
-            }
-            assert(page->GetPinCount() == 1);
-
-            // copy will contain all internal node's pair excluding the first one
-            // and plus the new one [key,value] which must be at the right position
-            auto *copy =
-                    reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                    KeyComparator> *>(page->GetData());
-            copy->Init(page_id);
-            copy->SetSize(internal->GetSize());
-            for (int i = 1, j = 0; i <= internal->GetSize(); ++i, ++j) {
-                if (internal->ValueAt(i - 1) == old_node->GetPageId()) {
-                    copy->SetKeyAt(j, key);
-                    copy->SetValueAt(j, new_node->GetPageId());
-                    ++j;
-                }
-                // the last one
-                if (i < internal->GetSize()) {
-                    copy->SetKeyAt(j, internal->KeyAt(i));
-                    copy->SetValueAt(j, internal->ValueAt(i));
-                }
-            }
-
-            // `internal2` will move (GetSize()+1)/2 pairs from `copy`
-            assert(copy->GetSize() == copy->GetMaxSize());
-            auto internal2 =
-            Split<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>(copy);
-
-            // `internal` have to copy back all pairs from `copy` start with index 1
-            // the left most pointer remain unchanged
-            internal->SetSize(copy->GetSize() + 1);
-            for (int i = 0; i < copy->GetSize(); ++i) {
-                internal->SetKeyAt(i + 1, copy->KeyAt(i));
-                internal->SetValueAt(i + 1, copy->ValueAt(i));
-            }
-
-            // set new node's parent page id
-            if (comparator_(key, internal2->KeyAt(0)) < 0) {
-                new_node->SetParentPageId(internal->GetPageId());
-            } else if (comparator_(key, internal2->KeyAt(0)) == 0) {
-                new_node->SetParentPageId(internal2->GetPageId());
-            } else {
-                new_node->SetParentPageId(internal2->GetPageId());
-                old_node->SetParentPageId(internal2->GetPageId());
-            }
-
-            // new_node is done, unpin it
-            buffer_pool_manager_->UnpinPage(new_node->GetPageId(), true);
-
-            // delete copy
-            buffer_pool_manager_->UnpinPage(copy->GetPageId(), false);
-            buffer_pool_manager_->DeletePage(copy->GetPageId());
-
-            // recursive call until root if necessary
-            InsertIntoParent(internal, internal2->KeyAt(0), internal2);
+            internal2->Insert(separator, new_page_id, comparator_);
         }
 
-        buffer_pool_manager_->UnpinPage(internal->GetPageId(), true);
+        // up one level until root if necessary
+        separator = internal2->KeyAt(0);
+        old_guard = std::move(guard);
     }
 }
 
@@ -340,26 +264,67 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
     // for debug
     //__attribute__((unused)) auto checker = Checker{buffer_pool_manager_};
 
-    if (IsEmpty()) {
+    // find the leaf node
+    WritePageGuard guard = FindPageWrite(key, 0);
+    if (!guard.IsValid()) {
+        return;
+    }
+    auto *leaf = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+    int size_before_deletion = leaf->GetSize();
+    if (leaf->RemoveAndDeleteRecord(key, comparator_) == size_before_deletion) {
+        return;
+    }
+    guard.SetDirty();
+    if (leaf->GetSize() >= leaf->GetMinSize()) {
         return;
     }
 
-    // find the leaf node
-    auto *leaf = FindLeafPage(key, false, Operation::DELETE, transaction);
-    if (leaf != nullptr) {
-        int size_before_deletion = leaf->GetSize();
-        if (leaf->RemoveAndDeleteRecord(key, comparator_) != size_before_deletion) {
-            //std::cerr << "thread: " << transaction->GetThreadId()
-            //          << ", remove key: " << key << ", root locked: "
-            //          << root_is_locked << std::endl;
-            if (CoalesceOrRedistribute(leaf, transaction)) {
-                transaction->AddIntoDeletedPageSet(leaf->GetPageId());
+    if (guard.GetPageId() == root_page_id_) {
+        // root is a leaf node, delete the last element in whole b+ tree
+        if (leaf->GetSize() == 0) {
+            page_id_t page_id = guard.GetPageId();
+            root_page_id_ = INVALID_PAGE_ID;
+            UpdateRootPageId(false);
+            guard.Release();
+            if (!buffer_pool_manager_->DeletePage(page_id)) {
+                throw Exception(EXCEPTION_TYPE_INDEX,
+                                "can not delete page while Remove");
             }
+        }
+        return;
+    }
+
+    // the parent is latched before the leaf, release it and go down again
+    guard.Release();
+    CoalesceOrRedistribute(key, 0);
+}
+
+/*
+ * Rebalance the page of level covering key with a sibling, under the parent
+ * page, write latched first. When this merges two pages the parent loses one,
+ * then repeat one level up.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(const KeyType &key, int level) {
+    while (true) {
+        WritePageGuard parent_guard = FindPageWrite(key, level + 1);
+        if (!parent_guard.IsValid()) {
+            return;
+        }
+        bool parent_underflow;
+        if (level == 0) {
+            parent_underflow = CoalesceOrRedistribute<
+                    BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>(
+                    parent_guard, key);
         } else {
-            //std::cerr << "thread: " << transaction->GetThreadId()
-            //          << ", key not exists: " << key << std::endl;
+            parent_underflow = CoalesceOrRedistribute<
+                    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>>(
+                    parent_guard, key);
         }
-        UnlockUnpinPages(Operation::DELETE, transaction);
+        if (!parent_underflow) {
+            return;
+        }
+        ++level;
     }
 }
 
@@ -367,206 +332,157 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
+ * The page under parent covering key is checked once latched: another writer
+ * may have filled it meanwhile, or split its sibling without telling parent
+ * yet, both pages are then left as they are.
+ * @return: true means parent node is underfull now, false means no
+ * further rebalance is needed
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-// Base condition: reach root node
-    if (node->IsRootPage()) {
-        return AdjustRoot(node);
-    }
-    // no need to delete node
-    if (node->IsLeafPage()) {
-        if (node->GetSize() >= node->GetMinSize()) {
-            return false;
-        }
-    } else {
-        if (node->GetSize() > node->GetMinSize()) {
-            return false;
-        }
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(WritePageGuard &parent_guard,
+                                            const KeyType &key) {
+    auto parent = parent_guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+            KeyComparator>>();
+    // no sibling under this parent
+    if (parent->GetSize() < 2) {
+        return false;
     }
+    // find sibling first, always find the previous one if possible
+    int value_index = parent->LookupIndex(key, comparator_);
+    int right_index = value_index == 0 ? 1 : value_index;
 
-    // get parent first
-    auto *page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-    if (page == nullptr) {
+    // fetch both, left to right
+    WritePageGuard left_guard =
+            buffer_pool_manager_->FetchPageWrite(parent->ValueAt(right_index - 1));
+    if (!left_guard.IsValid()) {
         throw Exception(EXCEPTION_TYPE_INDEX,
                         "all page are pinned while CoalesceOrRedistribute");
     }
-    // find sibling first, always find the previous one if possible
-    auto parent =
-            reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-            KeyComparator> *>(page->GetData());
-    // sibling should has the same parent with node
-    int value_index = parent->ValueIndex(node->GetPageId());
-
-    // when can't find, ValueIndex() will return GetSize();
-    assert(value_index != parent->GetSize());
-
-    int sibling_page_id;
-    if (value_index == 0) {
-        sibling_page_id = parent->ValueAt(value_index + 1);
-    } else {
-        sibling_page_id = parent->ValueAt(value_index - 1);
-    }
-
-    // fetch sibling node
-    page = buffer_pool_manager_->FetchPage(sibling_page_id);
-    if (page == nullptr) {
+    WritePageGuard right_guard =
+            buffer_pool_manager_->FetchPageWrite(parent->ValueAt(right_index));
+    if (!right_guard.IsValid()) {
         throw Exception(EXCEPTION_TYPE_INDEX,
                         "all page are pinned while CoalesceOrRedistribute");
     }
+    auto *left = left_guard.template As<N>();
+    auto *right = right_guard.template As<N>();
+    if (left->GetNextPageId() != right_guard.GetPageId()) {
+        return false;
+    }
 
-    // put sibling node to PageSet
-    page->WLatch();
-    transaction->AddIntoPageSet(page);
-    auto sibling = reinterpret_cast<N *>(page->GetData());
-    bool redistribute = false;
+    // no need to rebalance node, leaf node is a little bit different with
+    // internal node (key[0] is reserved)
+    N *node = value_index == 0 ? left : right;
+    if (node->IsLeafPage() ? node->GetSize() >= node->GetMinSize()
+                           : node->GetSize() > node->GetMinSize()) {
+        return false;
+    }
 
-    // 1. leaf node is a little bit different with internal node (key[0] is reserved)
-    // when determine distribution or coalescing.
-    // 2. the actually key number in internal node is `GetSize() -1 `
+    parent_guard.SetDirty();
+    left_guard.SetDirty();
+    right_guard.SetDirty();
+    // 1. the actually key number in internal node is `GetSize() -1 `
     // and must plus separation key in the parent when consider distribution
-    // 3. but the condition for leaf/internal node is same
-    if (sibling->GetSize() + node->GetSize() > node->GetMaxSize()) {
-        redistribute = true;
-        // release parent
-        buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+    // 2. but the condition for leaf/internal node is same
+    if (left->GetSize() + right->GetSize() > node->GetMaxSize()) {
+        Redistribute<N>(left, right, parent, right_index, node == left);
+        return false;
     }
 
-    // redistribute key-value pairs
-    if (redistribute) {
-        if (value_index == 0) {
-            Redistribute<N>(sibling, node, 0);   // sibling is successor of node
-        } else {
-            Redistribute<N>(sibling, node, 1);   // sibling is predecessor of node
-        }
-        return false;
+    Coalesce<N>(left, right, parent, right_index);
+    page_id_t right_page_id = right_guard.GetPageId();
+    right_guard.Release();
+    if (!buffer_pool_manager_->DeletePage(right_page_id)) {
+        throw Exception(EXCEPTION_TYPE_INDEX,
+                        "can not delete page while CoalesceOrRedistribute");
     }
 
-    // merge nodes: if node is the first child of its parent, swap node and
-    // its sibling when call Coalesce for the assumption
-    bool ret;
-    if (value_index == 0) {
-        // it's Coalesce's responsibility to delete/save parent
-        Coalesce<N>(node, sibling, parent, 1, transaction);
-        transaction->AddIntoDeletedPageSet(sibling_page_id);
-        // node should not be deleted
-        ret = false;
-    } else {
-        Coalesce<N>(sibling, node, parent, value_index, transaction);
-        // node should be deleted
-        ret = true;
+    if (parent_guard.GetPageId() == root_page_id_) {
+        AdjustRoot(parent_guard, left_guard);
+        return false;
     }
-    // release parent
-    buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
-    return ret;
+    return parent->GetSize() <= parent->GetMinSize();
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
+ * Move all the key & value pairs from right page to its left sibling, then
+ * remove right from the parent. The caller deletes right once released
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion
- * happend
+ * @param   left               left sibling of right
+ * @param   right              the page to empty
+ * @param   parent             parent page of both
+ * @param   index              index of right in parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 void BPLUSTREE_TYPE::Coalesce(
-    N *&neighbor_node, N *&node,
-    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-    int index, Transaction *transaction) {
-    // assumption: neighbor_node is predecessor of node
-    node->MoveAllTo(neighbor_node, index, buffer_pool_manager_);
+    N *left, N *right,
+    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+    int index) {
+    right->MoveAllTo(left, parent->KeyAt(index));
 
     // adjust parent
     parent->Remove(index);
-
-    // recursive
-    if (CoalesceOrRedistribute(parent, transaction)) {
-        transaction->AddIntoDeletedPageSet(parent->GetPageId());
-    }
 }
 
 /*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
+ * Redistribute key & value pairs between two siblings. If to_left, move
+ * right page's first key & value pair into end of left page, otherwise move
+ * left page's last key & value pair into head of right page. The first key of
+ * right is the new separator, in parent and as high key of left.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
+ * @param   index              index of right in parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
-    if (index == 0) {
-        neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
+void BPLUSTREE_TYPE::Redistribute(
+    N *left, N *right,
+    BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *parent,
+    int index, bool to_left) {
+    if (to_left) {
+        right->MoveFirstToEndOf(left, parent->KeyAt(index));
     } else {
-        auto *page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-        if (page == nullptr) {
-            throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while Redistribute");
-        }
-        auto parent =
-                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                KeyComparator> *>(page->GetData());
-        int idx = parent->ValueIndex(node->GetPageId());
-        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-
-        neighbor_node->MoveLastToFrontOf(node, idx, buffer_pool_manager_);
+        left->MoveLastToFrontOf(right, parent->KeyAt(index));
     }
+    parent->SetKeyAt(index, right->KeyAt(0));
+    left->SetHighKey(right->KeyAt(0));
 }
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
  * called within coalesceOrRedistribute() method
  * case 1: when you delete the last element in root page, but root page still
- * has one last child
- * case 2: when you delete the last element in whole b+ tree
- * @return : true means root page should be deleted, false means no deletion
+ * has one last child, it becomes the root. Not while a split of the child is
+ * on its way to the root: the child would have a sibling
+ * case 2: when you delete the last element in whole b+ tree, see Remove()
+ * @return : true means root page is deleted, false means no deletion
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-    // root is a leaf node, case 2
-    if (old_root_node->IsLeafPage()) {
-        if (old_root_node->GetSize() == 0) {
-            root_page_id_ = INVALID_PAGE_ID;
-            UpdateRootPageId(false);
-            return true;
-        }
+bool BPLUSTREE_TYPE::AdjustRoot(WritePageGuard &root_guard,
+                                WritePageGuard &child_guard) {
+    auto root = root_guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+            KeyComparator>>();
+    auto *child = child_guard.As<BPlusTreePage>();
+    page_id_t next_page_id = child->IsLeafPage()
+            ? child_guard.As<BPlusTreeLeafPage<KeyType, ValueType,
+                      KeyComparator>>()->GetNextPageId()
+            : child_guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+                      KeyComparator>>()->GetNextPageId();
+    if (root->GetSize() != 1 || next_page_id != INVALID_PAGE_ID) {
         return false;
     }
 
-    // root is a internal node, case 1
-    if (old_root_node->GetSize() == 1) {
-        auto root =
-                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                KeyComparator> *>(old_root_node);
-        root_page_id_ = root->ValueAt(0);
-        UpdateRootPageId(false);
-
-        // set the new root's parent id "INVALID_PAGE_ID"
-        auto *page = buffer_pool_manager_->FetchPage(root_page_id_);
-        if (page == nullptr) {
-            throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while AdjustRoot");
-        }
-        auto new_root =
-                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
-                KeyComparator> *>(page->GetData());
-        new_root->SetParentPageId(INVALID_PAGE_ID);
-        buffer_pool_manager_->UnpinPage(root_page_id_, true);
-        return true;
+    page_id_t page_id = root_guard.GetPageId();
+    root_page_id_ = child_guard.GetPageId();
+    UpdateRootPageId(false);
+    root_guard.Release();
+    if (!buffer_pool_manager_->DeletePage(page_id)) {
+        throw Exception(EXCEPTION_TYPE_INDEX,
+                        "can not delete page while AdjustRoot");
     }
-    return false;
+    return true;
 }
 
 /*****************************************************************************
@@ -581,7 +497,7 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
     KeyType key{};
     return IndexIterator<KeyType, ValueType, KeyComparator>(
-            FindLeafPage(key, true), 0, buffer_pool_manager_);
+            FindLeafPageRead(key, true), 0, buffer_pool_manager_);
 }
 
 /*
@@ -591,158 +507,325 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-    auto *leaf = FindLeafPage(key, false);
+    ReadPageGuard guard = FindLeafPageRead(key);
     int index = 0;
-    if (leaf != nullptr) {
-        index = leaf->KeyIndex(key, comparator_);
+    if (guard.IsValid()) {
+        index = guard.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>()
+                ->KeyIndex(key, comparator_);
     }
     return IndexIterator<KeyType, ValueType, KeyComparator>(
-            leaf, index, buffer_pool_manager_);
+            std::move(guard), index, buffer_pool_manager_);
 }
 
-template <typename KeyType, typename ValueType, typename KeyComparator>
-void BPlusTree<KeyType, ValueType, KeyComparator>::
-UnlockUnpinPages(Operation op, Transaction *transaction) {
-    if (transaction == nullptr) {
-        return;
-    }
-
-    for (auto *page:*transaction->GetPageSet()) {
-        //assert(page->GetPinCount() == 1);
-        if (op == Operation::READONLY) {
-            page->RUnlatch();
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
-        } else {
-            page->WUnlatch();
-            buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+/*
+ * Walk down to the leaf holding key (or the left most leaf). The internal
+ * nodes in the pool are read optimistically, neither pinned nor latched, so a
+ * descent writes no shared cache line until it reaches the leaf, or a page
+ * that is not resident. That page is fetched with a read guard, then the
+ * version of its parent is validated: had the parent changed, a split or a
+ * merge may have moved key away and the descent restarts. After
+ * OPTIMISTIC_RETRY_NUM restarts, fall back to latch crabbing from the root
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ReadPageGuard BPLUSTREE_TYPE::FindLeafPageRead(const KeyType &key, bool leftMost) {
+    for (int attempt = 0; attempt < OPTIMISTIC_RETRY_NUM; ++attempt) {
+        page_id_t root_page_id = root_page_id_;
+        if (root_page_id == INVALID_PAGE_ID) {
+            return ReadPageGuard();
         }
+        page_id_t page_id = root_page_id;
+        Page *parent = nullptr;
+        uint64_t parent_version = 0;
+        if (!FindLeafPageOptimistic(key, leftMost, page_id, parent,
+                                    parent_version)) {
+            continue;
+        }
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(page_id);
+        if (!guard.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while FindLeafPage");
+        }
+        if (parent != nullptr ? !parent->ValidateLatch(parent_version)
+                              : root_page_id != root_page_id_) {
+            continue;
+        }
+        return CrabToLeaf(std::move(guard), key, leftMost);
     }
-    transaction->GetPageSet()->clear();
-
-    // delete all pages
-    for (auto page_id: *transaction->GetDeletedPageSet()) {
-        buffer_pool_manager_->DeletePage(page_id);
-    }
-    transaction->GetDeletedPageSet()->clear();
-
-    // if root is locked, unlock it
-    if (root_is_locked) {
-        root_is_locked = false;
-        unlockRoot();
+    while (true) {
+        page_id_t root_page_id = root_page_id_;
+        if (root_page_id == INVALID_PAGE_ID) {
+            return ReadPageGuard();
+        }
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id);
+        if (!guard.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while FindLeafPage");
+        }
+        // the root may have been merged away before it was latched
+        if (root_page_id == root_page_id_) {
+            return CrabToLeaf(std::move(guard), key, leftMost);
+        }
     }
 }
 
 /*
- * Note: leaf node and internal node have different MAXSIZE
+ * Optimistic part of FindLeafPageRead(): from page_id, follow the internal
+ * nodes that can be read without latching. Stop at the first page that is a
+ * leaf, not resident or write latched, leaving its id in page_id and its
+ * parent with the version it was read at in parent (nullptr at the root).
+ * return false if a version check failed, nothing read can be trusted then.
+ * The shell of parent stays valid after the epoch ends, only its content may
+ * be freed by a pool shrink.
+ * A child found through the page table is swizzled into the frame of its
+ * parent, the next descents through that slot go straight to the frame. A
+ * right sibling is followed like a child, but never swizzled
  */
-template <typename KeyType, typename ValueType, typename KeyComparator>
-template <typename N>
-bool BPlusTree<KeyType, ValueType, KeyComparator>::
-isSafe(N *node, Operation op) {
-    if (op == Operation::INSERT) {
-        return node->GetSize() < node->GetMaxSize();
-    } else if (op == Operation::DELETE) {
-        // >=: keep same with `coalesce logic`
-        return node->GetSize() > node->GetMinSize() + 1;
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::FindLeafPageOptimistic(const KeyType &key, bool leftMost,
+                                            page_id_t &page_id, Page *&parent,
+                                            uint64_t &parent_version) {
+    EpochGuard epoch;
+    int slot = 0;
+    Page *swizzled = nullptr;
+    while (true) {
+        uint64_t version;
+        Page *page = buffer_pool_manager_->FetchPageOptimistic(page_id, version,
+                                                               swizzled);
+        if (page == nullptr) {
+            return true;
+        }
+        if (parent != nullptr && page != swizzled) {
+            parent->Swizzle(slot, page);
+        }
+        auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+        if (node->IsLeafPage()) {
+            return page->ValidateLatch(version);
+        }
+        auto internal =
+                reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
+                KeyComparator> *>(node);
+        page_id_t child_page_id;
+        if (leftMost) {
+            slot = 0;
+            child_page_id = internal->ValueAt(0);
+        } else if ((child_page_id = GetRightPageId(node, key)) !=
+                   INVALID_PAGE_ID) {
+            slot = -1;
+        } else {
+            child_page_id = internal->LookupOptimistic(key, comparator_, slot);
+        }
+        if (!page->ValidateLatch(version)) {
+            return false;
+        }
+        // the root may have been merged away before it was read
+        if (parent == nullptr && page_id != root_page_id_) {
+            return false;
+        }
+        swizzled = page->GetSwizzled(slot);
+        page_id = child_page_id;
+        parent = page;
+        parent_version = version;
     }
-    return true;
 }
 
-
-/*****************************************************************************
- * UTILITIES AND DEBUG
- *****************************************************************************/
 /*
- * Find leaf page containing particular key, if leftMost flag == true, find
- * the left most leaf page
+ * Walk down with S latches only. The child is latched before the guard of its
+ * parent is released, and the pin taken by each fetch is the one the guard
+ * gives back
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *
-        BPlusTree<KeyType, ValueType, KeyComparator>::
-                FindLeafPage(const KeyType &key, bool leftMost, Operation op, Transaction *transaction){
-    if (op != Operation::READONLY) {
-        lockRoot();
-        root_is_locked = true;
-    }
-
-    // empty B+ tree?
-    if (IsEmpty()) {
-        return nullptr;
-    }
-
-    // walk from root node
-    auto *parent = buffer_pool_manager_->FetchPage(root_page_id_);
-    if (parent == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while FindLeafPage");
-    }
-
-    if (op == Operation::READONLY) {
-        parent->RLatch();
-    } else {
-        parent->WLatch();
-        //if (op == Operation::DELETE) {
-        //  std::cerr << "thread: " << transaction->GetThreadId() << ", page "
-        //            << parent->GetPageId() << ": X lock, key: " << key << std::endl;
-        //}
-    }
-    if (transaction != nullptr) {
-        transaction->AddIntoPageSet(parent);
-    }
-
-    // Uniform page -> BPlusTree page
-    auto *node = reinterpret_cast<BPlusTreePage *>(parent->GetData());
-    while (!node->IsLeafPage()) {
+ReadPageGuard BPLUSTREE_TYPE::CrabToLeaf(ReadPageGuard guard, const KeyType &key,
+                                         bool leftMost) {
+    while (true) {
+        if (!leftMost) {
+            MoveRight(guard, key);
+        }
+        auto *node = guard.As<BPlusTreePage>();
+        if (node->IsLeafPage()) {
+            return guard;
+        }
         auto internal =
                 reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t,
                 KeyComparator> *>(node);
-        page_id_t parent_page_id = node->GetPageId(), child_page_id;
+        page_id_t child_page_id;
         if (leftMost) {
             child_page_id = internal->ValueAt(0);
         } else {
             child_page_id = internal->Lookup(key, comparator_);
         }
+        ReadPageGuard child = buffer_pool_manager_->FetchPageRead(child_page_id);
+        if (!child.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while FindLeafPage");
+        }
+        guard = std::move(child);
+    }
+}
+
+/*
+ * Crab down like CrabToLeaf() from the root, until the page of level, which is
+ * write latched before its parent is released. The root is checked once
+ * latched: it changes, to a new page, only with the old root write latched.
+ * A leaf is first looked for optimistically, the root is then neither latched
+ * nor pinned: read latching it writes the same cache line on every core
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FindPageWrite(const KeyType &key, int level) {
+    if (level == 0 && ENABLE_OPTIMISTIC_WRITES) {
+        WritePageGuard guard = FindLeafPageWriteOptimistic(key);
+        if (guard.IsValid()) {
+            return guard;
+        }
+    }
+    while (true) {
+        page_id_t root_page_id = root_page_id_;
+        if (root_page_id == INVALID_PAGE_ID) {
+            return WritePageGuard();
+        }
+        ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(root_page_id);
+        if (!guard.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while FindPageWrite");
+        }
+        if (root_page_id != root_page_id_) {
+            continue;
+        }
+        int root_level = guard.As<BPlusTreePage>()->GetLevel();
+        if (root_level < level) {
+            return WritePageGuard();
+        }
+        if (root_level == level) {
+            guard.Release();
+            WritePageGuard root = buffer_pool_manager_->FetchPageWrite(root_page_id);
+            if (!root.IsValid()) {
+                throw Exception(EXCEPTION_TYPE_INDEX,
+                                "all page are pinned while FindPageWrite");
+            }
+            if (root_page_id != root_page_id_) {
+                continue;
+            }
+            return root;
+        }
+
+        while (true) {
+            MoveRight(guard, key);
+            auto internal = guard.As<BPlusTreeInternalPage<KeyType, page_id_t,
+                    KeyComparator>>();
+            page_id_t child_page_id = internal->Lookup(key, comparator_);
+            if (internal->GetLevel() == level + 1) {
+                WritePageGuard child =
+                        buffer_pool_manager_->FetchPageWrite(child_page_id);
+                if (!child.IsValid()) {
+                    throw Exception(EXCEPTION_TYPE_INDEX,
+                                    "all page are pinned while FindPageWrite");
+                }
+                guard.Release();
+                MoveRight(child, key);
+                return child;
+            }
+            ReadPageGuard child = buffer_pool_manager_->FetchPageRead(child_page_id);
+            if (!child.IsValid()) {
+                throw Exception(EXCEPTION_TYPE_INDEX,
+                                "all page are pinned while FindPageWrite");
+            }
+            guard = std::move(child);
+        }
+    }
+}
 
-        // find child
-        auto *child = buffer_pool_manager_->FetchPage(child_page_id);
-        if (child == nullptr) {
+/*
+ * Same descent as FindLeafPageRead(), except that the page it stops at is write
+ * latched, then the version of its parent validated. The optimistic descent
+ * only stops above the leaf level at an internal page that is not resident or
+ * being changed, FindPageWrite() then crabs down instead
+ */
+INDEX_TEMPLATE_ARGUMENTS
+WritePageGuard BPLUSTREE_TYPE::FindLeafPageWriteOptimistic(const KeyType &key) {
+    for (int attempt = 0; attempt < OPTIMISTIC_RETRY_NUM; ++attempt) {
+        page_id_t root_page_id = root_page_id_;
+        if (root_page_id == INVALID_PAGE_ID) {
+            return WritePageGuard();
+        }
+        page_id_t page_id = root_page_id;
+        Page *parent = nullptr;
+        uint64_t parent_version = 0;
+        if (!FindLeafPageOptimistic(key, false, page_id, parent,
+                                    parent_version)) {
+            continue;
+        }
+        WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(page_id);
+        if (!guard.IsValid()) {
             throw Exception(EXCEPTION_TYPE_INDEX,
                             "all page are pinned while FindLeafPage");
         }
+        if (parent != nullptr ? !parent->ValidateLatch(parent_version)
+                              : root_page_id != root_page_id_) {
+            continue;
+        }
+        if (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+            return WritePageGuard();
+        }
+        MoveRight(guard, key);
+        return guard;
+    }
+    return WritePageGuard();
+}
 
-        if (op == Operation::READONLY) {
-            // acquire S lock on child
-            child->RLatch();
-            // release S lock on parent
-            UnlockUnpinPages(op, transaction);
-        } else {
-            // acquire X lock
-            child->WLatch();
-            //if (op == Operation::DELETE) {
-            //  std::cerr << "thread: " << transaction->GetThreadId() << ", page "
-            //            << child->GetPageId() << ": X lock, key: " << key << std::endl;
-            //}
-        }
-        // sanity check, parent page id must match
-        node = reinterpret_cast<BPlusTreePage *>(child->GetData());
-        assert(node->GetParentPageId() == parent_page_id);
-
-        // is child node safe ?
-        if (op != Operation::READONLY && isSafe(node, op)) {
-            UnlockUnpinPages(op, transaction);
-        }
-        if (transaction != nullptr) {
-            //transaction->GetPageSet()->push_back(child);
-            transaction->AddIntoPageSet(child);
-        } else {
-            // for Index Iterator
-            parent->RUnlatch();
-            buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
-            parent = child;
+/*
+ * Move right from the page held by guard, latching the sibling before the
+ * page is released, as long as key is not below the high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MoveRight(ReadPageGuard &guard, const KeyType &key) {
+    page_id_t next_page_id;
+    while ((next_page_id = GetRightPageId(guard.As<BPlusTreePage>(), key)) !=
+           INVALID_PAGE_ID) {
+        ReadPageGuard next = buffer_pool_manager_->FetchPageRead(next_page_id);
+        if (!next.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while MoveRight");
+        }
+        guard = std::move(next);
+    }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::MoveRight(WritePageGuard &guard, const KeyType &key) {
+    page_id_t next_page_id;
+    while ((next_page_id = GetRightPageId(guard.As<BPlusTreePage>(), key)) !=
+           INVALID_PAGE_ID) {
+        WritePageGuard next = buffer_pool_manager_->FetchPageWrite(next_page_id);
+        if (!next.IsValid()) {
+            throw Exception(EXCEPTION_TYPE_INDEX,
+                            "all page are pinned while MoveRight");
         }
+        guard = std::move(next);
+    }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::GetRightPageId(BPlusTreePage *node,
+                                         const KeyType &key) {
+    page_id_t next_page_id;
+    KeyType high_key;
+    if (node->IsLeafPage()) {
+        auto leaf = reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType,
+                KeyComparator> *>(node);
+        next_page_id = leaf->GetNextPageId();
+        high_key = leaf->GetHighKey();
+    } else {
+        auto internal = reinterpret_cast<BPlusTreeInternalPage<KeyType,
+                page_id_t, KeyComparator> *>(node);
+        next_page_id = internal->GetNextPageId();
+        high_key = internal->GetHighKey();
+    }
+    if (next_page_id == INVALID_PAGE_ID || comparator_(key, high_key) < 0) {
+        return INVALID_PAGE_ID;
     }
-    return reinterpret_cast<BPlusTreeLeafPage<KeyType,
-    ValueType, KeyComparator> *>(node);
+    return next_page_id;
 }
 
 /*
@@ -755,15 +838,14 @@ BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record)
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  else
+  auto guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID);
+  HeaderPage *header_page = static_cast<HeaderPage *>(guard.GetPage());
+  guard.SetDirty();
+  // create a new record<index_name + root_page_id> in header_page, a tree
+  // started again after it was emptied has one already
+  if (!insert_record || !header_page->InsertRecord(index_name_, root_page_id_))
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -813,5 +895,7 @@ template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTree<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 
 } // namespace scudb
@@ -12,7 +12,8 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata,
                                      BufferPoolManager *buffer_pool_manager,
                                      page_id_t root_page_id)
-    : Index(metadata), comparator_(metadata->GetKeySchema()),
+    : Index(metadata),
+      comparator_(metadata->GetKeySchema(), metadata->HasNormalizedKeys()),
       container_(metadata->GetName(), buffer_pool_manager, comparator_,
                  root_page_id) {}
 
@@ -21,7 +22,7 @@ void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  SetIndexKey(index_key, key);
 
   container_.Insert(index_key, rid, transaction);
 }
@@ -31,7 +32,7 @@ void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
                                        Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  SetIndexKey(index_key, key);
 
   container_.Remove(index_key, transaction);
 }
@@ -41,14 +42,26 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
                                    Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  SetIndexKey(index_key, key);
 
   container_.GetValue(index_key, result, transaction);
 }
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::SetIndexKey(KeyType &index_key,
+                                       const Tuple &key) const {
+  if (GetMetadata()->HasNormalizedKeys()) {
+    index_key.SetFromKey(key, GetKeySchema());
+  } else {
+    index_key.SetFromKey(key);
+  }
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class BPlusTreeIndex<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 
 } // namespace scudb
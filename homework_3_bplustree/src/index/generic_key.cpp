@@ -0,0 +1,102 @@
+/**
+ * generic_key.cpp
+ */
+
+#include "common/exception.h"
+#include "index/generic_key.h"
+
+namespace scudb {
+
+namespace {
+// appends to a key buffer, dropping what does not fit
+class KeyWriter {
+public:
+  KeyWriter(char *data, size_t size) : data_(data), size_(size) {}
+
+  inline void Put(uint8_t byte) {
+    if (length_ < size_) {
+      data_[length_] = static_cast<char>(byte);
+    }
+    ++length_;
+  }
+
+  // bits big endian, most significant byte first
+  inline void PutBigEndian(uint64_t bits, size_t width) {
+    for (size_t i = width; i > 0; --i) {
+      Put(static_cast<uint8_t>(bits >> ((i - 1) * 8)));
+    }
+  }
+
+  // flipping the sign bit orders two's complement like unsigned
+  inline void PutSigned(int64_t value, size_t width) {
+    uint64_t sign = uint64_t(1) << (width * 8 - 1);
+    PutBigEndian(static_cast<uint64_t>(value) ^ sign, width);
+  }
+
+  inline size_t GetLength() const { return length_; }
+
+private:
+  char *data_;
+  size_t size_;
+  size_t length_ = 0;
+};
+} // namespace
+
+size_t NormalizeKey(const Tuple &tuple, Schema *key_schema, char *data,
+                    size_t size) {
+  KeyWriter writer(data, size);
+  for (int i = 0; i < key_schema->GetColumnCount(); ++i) {
+    Value value = tuple.GetValue(key_schema, i);
+    switch (key_schema->GetType(i)) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      writer.PutSigned(value.GetAs<int8_t>(), sizeof(int8_t));
+      break;
+    case TypeId::SMALLINT:
+      writer.PutSigned(value.GetAs<int16_t>(), sizeof(int16_t));
+      break;
+    case TypeId::INTEGER:
+      writer.PutSigned(value.GetAs<int32_t>(), sizeof(int32_t));
+      break;
+    case TypeId::BIGINT:
+      writer.PutSigned(value.GetAs<int64_t>(), sizeof(int64_t));
+      break;
+    case TypeId::TIMESTAMP:
+      writer.PutBigEndian(value.GetAs<uint64_t>(), sizeof(uint64_t));
+      break;
+    case TypeId::DECIMAL: {
+      // -0.0 equals 0.0. Positive doubles order as their bits with the sign
+      // flipped, negative ones as their bits inverted
+      double decimal = value.GetAs<double>();
+      if (decimal == 0) {
+        decimal = 0;
+      }
+      uint64_t bits;
+      memcpy(&bits, &decimal, sizeof(bits));
+      bits = (bits >> 63) != 0 ? ~bits : bits | (uint64_t(1) << 63);
+      writer.PutBigEndian(bits, sizeof(bits));
+      break;
+    }
+    case TypeId::VARCHAR: {
+      // the length counts a terminating '\0', NULL is the empty string
+      uint32_t length = value.IsNull() ? 0 : value.GetLength();
+      const char *chars = value.GetData();
+      for (uint32_t j = 0; j + 1 < length; ++j) {
+        writer.Put(static_cast<uint8_t>(chars[j]));
+        if (chars[j] == '\0') {
+          writer.Put(0x01);
+        }
+      }
+      writer.Put(0x00);
+      writer.Put(0x00);
+      break;
+    }
+    default:
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "type can not be normalized in a key");
+    }
+  }
+  return writer.GetLength();
+}
+
+} // namespace scudb
@@ -13,18 +13,17 @@ namespace scudb {
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::
-IndexIterator(BPlusTreeLeafPage<KeyType, ValueType, KeyComparator> *leaf,
-              int index_, BufferPoolManager *buff_pool_manager):
-    leaf_(leaf), index_(index_), buff_pool_manager_(buff_pool_manager) {}
-
-
-INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::
-~IndexIterator() {
-    buff_pool_manager_->FetchPage(leaf_->GetPageId())->RUnlatch();
-    buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-    buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-};
+IndexIterator(ReadPageGuard &&guard, int index_,
+              BufferPoolManager *buff_pool_manager):
+    guard_(std::move(guard)), leaf_(nullptr), index_(index_),
+    buff_pool_manager_(buff_pool_manager) {
+    // read the next leaf ahead while this one is scanned
+    if (guard_.IsValid()) {
+        leaf_ = guard_.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
+        buff_pool_manager_->PrefetchPages({leaf_->GetNextPageId()});
+        SkipToItem();
+    }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 bool INDEXITERATOR_TYPE::
@@ -46,37 +45,44 @@ INDEX_TEMPLATE_ARGUMENTS
         INDEXITERATOR_TYPE &IndexIterator<KeyType, ValueType, KeyComparator>::
 operator++() {
     ++index_;
-    if (index_ == leaf_->GetSize() && leaf_->GetNextPageId() != INVALID_PAGE_ID) {
-        // first unpin leaf_, then get the next leaf
+    SkipToItem();
+    return *this;
+};
+
+/*
+ * Move to the first item of the next non empty leaf once past the last item of
+ * the current one. A leaf emptied by deletions stays linked until a merge
+ * catches up with it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipToItem() {
+    while (index_ == leaf_->GetSize() &&
+           leaf_->GetNextPageId() != INVALID_PAGE_ID) {
         page_id_t next_page_id = leaf_->GetNextPageId();
 
-        auto *page = buff_pool_manager_->FetchPage(next_page_id);
-        if (page == nullptr) {
+        auto next = buff_pool_manager_->FetchPageRead(next_page_id);
+        if (!next.IsValid()) {
             throw Exception(EXCEPTION_TYPE_INDEX,
                             "all page are pinned while IndexIterator(operator++)");
         }
         // first acquire next page, then release previous page
-        page->RLatch();
-
-        buff_pool_manager_->FetchPage(leaf_->GetPageId())->RUnlatch();
-        buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
-        buff_pool_manager_->UnpinPage(leaf_->GetPageId(), false);
+        guard_ = std::move(next);
 
         auto next_leaf =
-                reinterpret_cast<BPlusTreeLeafPage<KeyType, ValueType,
-                KeyComparator> *>(page->GetData());
+                guard_.As<BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>>();
         assert(next_leaf->IsLeafPage());
         index_ = 0;
         leaf_ = next_leaf;
+        buff_pool_manager_->PrefetchPages({leaf_->GetNextPageId()});
     }
-    return *this;
-};
-
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
 template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
 template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+template class IndexIterator<IntegerKey<int32_t>, RID, IntegerComparator<int32_t>>;
+template class IndexIterator<IntegerKey<int64_t>, RID, IntegerComparator<int64_t>>;
 
 } // namespace scudb
@@ -0,0 +1,76 @@
+/**
+ * key_search.cpp
+ */
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "index/key_search.h"
+
+namespace scudb {
+
+template <typename IntType>
+static int CountLessScalar(const char *base, size_t stride, int n, IntType key,
+                           bool or_equal) {
+  int count = 0;
+  for (int i = 0; i < n; ++i) {
+    IntType value;
+    memcpy(&value, base + i * stride, sizeof(IntType));
+    count += or_equal ? value <= key : value < key;
+  }
+  return count;
+}
+
+/*
+ * Gathers load the strided keys 8 (int32) or 4 (int64) at a time. key > value
+ * counts the values below key, with or_equal the values not above it are
+ * those where value > key is false
+ */
+int CountLess(const char *base, size_t stride, int n, int32_t key,
+              bool or_equal) {
+  int count = 0;
+  int i = 0;
+#ifdef __AVX2__
+  const __m256i index = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+      _mm256_set1_epi32(static_cast<int>(stride)));
+  const __m256i keys = _mm256_set1_epi32(key);
+  for (; i + 8 <= n; i += 8) {
+    __m256i values = _mm256_i32gather_epi32(
+        reinterpret_cast<const int *>(base + i * stride), index, 1);
+    __m256i mask = or_equal ? _mm256_cmpgt_epi32(values, keys)
+                            : _mm256_cmpgt_epi32(keys, values);
+    int bits = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+    count += or_equal ? 8 - __builtin_popcount(bits)
+                      : __builtin_popcount(bits);
+  }
+#endif
+  return count + CountLessScalar(base + i * stride, stride, n - i, key,
+                                 or_equal);
+}
+
+int CountLess(const char *base, size_t stride, int n, int64_t key,
+              bool or_equal) {
+  int count = 0;
+  int i = 0;
+#ifdef __AVX2__
+  const __m256i index = _mm256_setr_epi64x(
+      0, static_cast<long long>(stride), static_cast<long long>(2 * stride),
+      static_cast<long long>(3 * stride));
+  const __m256i keys = _mm256_set1_epi64x(key);
+  for (; i + 4 <= n; i += 4) {
+    __m256i values = _mm256_i64gather_epi64(
+        reinterpret_cast<const long long *>(base + i * stride), index, 1);
+    __m256i mask = or_equal ? _mm256_cmpgt_epi64(values, keys)
+                            : _mm256_cmpgt_epi64(keys, values);
+    int bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+    count += or_equal ? 4 - __builtin_popcount(bits)
+                      : __builtin_popcount(bits);
+  }
+#endif
+  return count + CountLessScalar(base + i * stride, stride, n - i, key,
+                                 or_equal);
+}
+
+} // namespace scudb
@@ -1,10 +1,12 @@
 /**
  * b_plus_tree_internal_page.cpp
  */
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
 #include "common/exception.h"
+#include "index/key_search.h"
 #include "page/b_plus_tree_internal_page.h"
 
 namespace scudb {
@@ -13,20 +15,43 @@ namespace scudb {
  *****************************************************************************/
 /*
  * Init method after creating a new internal page
- * Including set page type, set current size, set page id, set parent id and set
- * max page size
+ * Including set page type, set current size, set page id, set level, set next
+ * page id and set max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, int level) {
     SetPageType(IndexPageType::INTERNAL_PAGE);
     SetSize(1);
     SetPageId(page_id);
-    SetParentPageId(parent_id);
+    SetLevel(level);
+    SetNextPageId(INVALID_PAGE_ID);
     int size = (PAGE_SIZE - sizeof(BPlusTreeInternalPage))/
-               (sizeof(KeyType) + sizeof(ValueType));
+               sizeof(MappingType);
     SetMaxSize(size);
 }
+
+/*
+ * Helper methods to get/set the right sibling and the high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const {
+    return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+    next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const {
+    return high_key_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &key) {
+    high_key_ = key;
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
@@ -90,13 +115,36 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
-  assert(GetSize() > 1);
-  for(int i=0; i<GetSize(); i++){
-      if(comparator(key, array[i].first)==-1){
-          return array[i-1].second;
-      }
+  return array[LookupIndex(key, comparator)].second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
+  assert(GetSize() >= 1);
+  // the key of the first pair is invalid, search from the second one for the
+  // first key above key, the child before it covers key
+  return KeySearch<KeyType, ValueType, KeyComparator>::Bound(
+             array, 1, GetSize(), key, comparator, true) - 1;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType
+B_PLUS_TREE_INTERNAL_PAGE_TYPE::LookupOptimistic(const KeyType &key,
+                                                 const KeyComparator &comparator,
+                                                 int &index) const {
+  int size = GetSize();
+  int capacity = static_cast<int>(
+      (PAGE_SIZE - sizeof(BPlusTreeInternalPage)) / sizeof(MappingType));
+  index = 0;
+  if (size < 1 || size > capacity) {
+    // torn read, whatever is returned fails validation
+    return array[0].second;
   }
-  return array[GetSize()-1].second;
+  // torn keys are out of order, the bound still is within [1, size]
+  index = KeySearch<KeyType, ValueType, KeyComparator>::Bound(
+      array, 1, size, key, comparator, true) - 1;
+  return array[index].second;
 }
 
 /*****************************************************************************
@@ -117,21 +165,19 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     IncreaseSize(1);
 }
 /*
- * Insert new_key & new_value pair right after the pair with its value ==
- * old_value
+ * Insert new_key & new_value pair right after the pair covering new_key. The
+ * position is found by key: the page that split may not be in this page yet,
+ * its own split being on the way, but the order of the keys is
  * @return:  new size after insertion
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
-    const ValueType &old_value, const KeyType &new_key,
-    const ValueType &new_value) {
-  for(int i=GetSize(); i>=1; i--){
-      if(array[i-1].second == old_value){
-          array[i] = {new_key, new_value};
-          break;
-      }
-      array[i] = array[i-1];
-  }
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &new_key,
+                                           const ValueType &new_value,
+                                           const KeyComparator &comparator) {
+  assert(GetSize() < GetMaxSize());
+  int index = LookupIndex(new_key, comparator) + 1;
+  std::move_backward(array + index, array + GetSize(), array + GetSize() + 1);
+  array[index] = {new_key, new_value};
   IncreaseSize(1);
   return GetSize();
 }
@@ -140,34 +186,26 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to "recipient" page, a new
+ * page that becomes the right sibling. The key of the first pair moved is the
+ * separator of the two, recipient takes over the high key of this page
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
-    BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {
+    BPlusTreeInternalPage *recipient) {
     auto half = (GetSize() + 1)/2;
-    recipient->CopyHalfFrom(array + GetSize() - half, half, buffer_pool_manager);
-
-    // update parent page id of all children
-    for (auto index = GetSize() - half; index < GetSize(); ++index) {
-        auto *page = buffer_pool_manager->FetchPage(ValueAt(index));
-        if (page == nullptr) {
-            throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while CopyLastFrom");
-        }
-        auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-        child->SetParentPageId(recipient->GetPageId());
-
-        assert(child->GetParentPageId() == recipient->GetPageId());
-        buffer_pool_manager->UnpinPage(child->GetPageId(), true);
-    }
+    recipient->CopyHalfFrom(array + GetSize() - half, half);
     IncreaseSize(-1*half);
+
+    recipient->SetNextPageId(GetNextPageId());
+    recipient->SetHighKey(GetHighKey());
+    SetNextPageId(recipient->GetPageId());
+    SetHighKey(recipient->KeyAt(0));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(MappingType *items,
+                                                  int size) {
     // must be a new page
     assert(!IsLeafPage() && GetSize() == 1 && size > 0);
     for (int i = 0; i < size; ++i) {
@@ -207,50 +245,23 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Remove all of key & value pairs from this page to "recipient" page, its
+ * left sibling, which takes over the high key and the right sibling of this
+ * page. The caller removes this page from the parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
-    BPlusTreeInternalPage *recipient, int index_in_parent,
-    BufferPoolManager *buffer_pool_manager) {
-// first find parent
-    auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while MoveAllTo");
-    }
-    auto *parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
-
+    BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
     // the separation key from parent
-    SetKeyAt(0, parent->KeyAt(index_in_parent));
-
-    // assumption: current page is at the right hand of recipient
-    assert(parent->ValueAt(index_in_parent) == GetPageId());
-
-    // unpin parent page
-    buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
-
-    recipient->CopyAllFrom(array, GetSize(), buffer_pool_manager);
-
-    // update parent page id of all children
-    for (auto index = 0; index < GetSize(); ++index) {
-        auto *page = buffer_pool_manager->FetchPage(ValueAt(index));
-        if (page == nullptr) {
-            throw Exception(EXCEPTION_TYPE_INDEX,
-                            "all page are pinned while CopyLastFrom");
-        }
-        auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-        child->SetParentPageId(recipient->GetPageId());
-
-        assert(child->GetParentPageId() == recipient->GetPageId());
-        buffer_pool_manager->UnpinPage(child->GetPageId(), true);
-    }
+    array[0].first = middle_key;
+    recipient->CopyAllFrom(array, GetSize());
+    recipient->SetNextPageId(GetNextPageId());
+    recipient->SetHighKey(GetHighKey());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(MappingType *items,
+                                                 int size) {
     assert(GetSize() + size <= GetMaxSize());
     int start = GetSize();
     for (int i = 0; i < size; ++i) {
@@ -264,108 +275,50 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
  *****************************************************************************/
 /*
  * Remove the first key & value pair from this page to tail of "recipient"
- * page, then update relavent key & value pair in its parent page.
+ * page, its left sibling. The first child goes with the separation key from
+ * parent, the key of the second pair becomes the new separation key
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {
+    BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
     assert(GetSize() > 1);
-    MappingType pair{KeyAt(1), ValueAt(0)};
-    page_id_t child_page_id = ValueAt(0);
-    SetValueAt(0, ValueAt(1));
-    Remove(1);
+    MappingType pair{middle_key, ValueAt(0)};
+    Remove(0);
 
     // delegate to helper function
-    recipient->CopyLastFrom(pair, buffer_pool_manager);
-
-    // update child parent page id
-    auto *page = buffer_pool_manager->FetchPage(child_page_id);
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while CopyLastFrom");
-    }
-    auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    child->SetParentPageId(recipient->GetPageId());
-
-    assert(child->GetParentPageId() == recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child->GetPageId(), true);
+    recipient->CopyLastFrom(pair);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
-    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair) {
     assert(GetSize() + 1 <= GetMaxSize());
-
-    auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while CopyLastFrom");
-    }
-    auto parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
-
-    auto index = parent->ValueIndex(GetPageId());
-    auto key = parent->KeyAt(index + 1);
-
-    array[GetSize()] = {key, pair.second};
+    array[GetSize()] = pair;
     IncreaseSize(1);
-    parent->SetKeyAt(index + 1, pair.first);
-
-    // unpin when we are done
-    buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
 }
 
 /*
  * Remove the last key & value pair from this page to head of "recipient"
- * page, then update relavent key & value pair in its parent page.
+ * page, its right sibling. The separation key from parent moves down to the
+ * child that was first in recipient, the key of the moved pair moves up
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeInternalPage *recipient, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {
+    BPlusTreeInternalPage *recipient, const KeyType &middle_key) {
     assert(GetSize() > 1);
     IncreaseSize(-1);
     MappingType pair = array[GetSize()];
-    page_id_t child_page_id = pair.second;
 
     // delegate
-    recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
-
-    // update child parent page id
-    auto *page = buffer_pool_manager->FetchPage(child_page_id);
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while CopyLastFrom");
-    }
-    auto child = reinterpret_cast<BPlusTreePage *>(page->GetData());
-    child->SetParentPageId(recipient->GetPageId());
-
-    assert(child->GetParentPageId() == recipient->GetPageId());
-    buffer_pool_manager->UnpinPage(child->GetPageId(), true);
+    recipient->SetKeyAt(0, middle_key);
+    recipient->CopyFirstFrom(pair);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &pair, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {
-    assert(GetSize() + 1 < GetMaxSize());
-
-    auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while CopyFirstFrom");
-    }
-    auto parent = reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
-
-    auto key = parent->KeyAt(parent_index);
-
-    // set parent key to the last of current page
-    parent->SetKeyAt(parent_index, pair.first);
-
-    InsertNodeAfter(array[0].second, key, array[0].second);
-    array[0].second = pair.second;
-
-    buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair) {
+    assert(GetSize() + 1 <= GetMaxSize());
+    std::move_backward(array, array + GetSize(), array + GetSize() + 1);
+    array[0] = pair;
+    IncreaseSize(1);
 }
 
 /*****************************************************************************
@@ -393,8 +346,8 @@ std::string B_PLUS_TREE_INTERNAL_PAGE_TYPE::ToString(bool verbose) const {
   }
   std::ostringstream os;
   if (verbose) {
-    os << "[pageId: " << GetPageId() << " parentId: " << GetParentPageId()
-       << "]<" << GetSize() << "> ";
+    os << "[pageId: " << GetPageId() << " level: " << GetLevel()
+       << " nextId: " << GetNextPageId() << "]<" << GetSize() << "> ";
   }
 
   int entry = verbose ? 0 : 1;
@@ -426,4 +379,8 @@ template class BPlusTreeInternalPage<GenericKey<32>, page_id_t,
                                            GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t,
                                            GenericComparator<64>>;
+template class BPlusTreeInternalPage<IntegerKey<int32_t>, page_id_t,
+                                       IntegerComparator<int32_t>>;
+template class BPlusTreeInternalPage<IntegerKey<int64_t>, page_id_t,
+                                       IntegerComparator<int64_t>>;
 } // namespace scudb
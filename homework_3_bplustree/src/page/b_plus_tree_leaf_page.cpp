@@ -2,13 +2,14 @@
  * b_plus_tree_leaf_page.cpp
  */
 
+#include <algorithm>
 #include <sstream>
 
 #include "common/exception.h"
 #include "common/rid.h"
+#include "index/key_search.h"
 #include "page/b_plus_tree_leaf_page.h"
 #include "common/logger.h"
-#include "page/b_plus_tree_internal_page.h"
 
 namespace scudb {
 
@@ -18,24 +19,24 @@ namespace scudb {
 
 /**
  * Init method after creating a new leaf page
- * Including set page type, set current size to zero, set page id/parent id, set
+ * Including set page type, set current size to zero, set page id/level, set
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id) {
     SetPageType(IndexPageType::LEAF_PAGE);
     // set current size: 1 for the first invalid key
     SetSize(0);
     // set page id
     SetPageId(page_id);
-    // set parent id
-    SetParentPageId(parent_id);
+    // leaves are at the bottom level
+    SetLevel(0);
     // set next page id
     SetNextPageId(INVALID_PAGE_ID);
 
     // set max page size, header is 28bytes
     int size = (PAGE_SIZE - sizeof(BPlusTreeLeafPage))/
-               (sizeof(KeyType) + sizeof(ValueType));
+               sizeof(MappingType);
     SetMaxSize(size);
 }
 
@@ -52,19 +53,29 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
     next_page_id_ = next_page_id;
 }
 
+/**
+ * Helper methods to set/get the high key, meaningless without a next page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::GetHighKey() const {
+    return high_key_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetHighKey(const KeyType &key) {
+    high_key_ = key;
+}
+
 /**
  * Helper method to find the first index i so that array[i].first >= key
- * NOTE: This method is only used when generating index iterator
+ * NOTE: Used when generating index iterator, and to locate the key of
+ * Insert(), Lookup() and RemoveAndDeleteRecord()
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(
     const KeyType &key, const KeyComparator &comparator) const {
-    for (int i = 0; i < GetSize(); ++i) {
-        if (comparator(key, array[i].first) <= 0) {
-            return i;
-        }
-    }
-    return GetSize();
+    return KeySearch<KeyType, ValueType, KeyComparator>::Bound(
+            array, 0, GetSize(), key, comparator, false);
 }
 
 /*
@@ -100,29 +111,11 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
                                        const ValueType &value,
                                        const KeyComparator &comparator) {
-// empty or bigger than last value in the page
-    if (GetSize() == 0 || comparator(key, KeyAt(GetSize() - 1)) > 0) {
-        array[GetSize()] = {key, value};
-    } else if (comparator(key, array[0].first) < 0) {
-        memmove(array + 1, array, static_cast<size_t>(GetSize()*sizeof(MappingType)));
-        array[0] = {key, value};
-    } else {
-        int low = 0, high = GetSize() - 1, mid;
-        while (low < high && low + 1 != high) {
-            mid = low + (high - low)/2;
-            if (comparator(key, array[mid].first) < 0) {
-                high = mid;
-            } else if (comparator(key, array[mid].first) > 0) {
-                low = mid;
-            } else {
-                // only support unique key
-                assert(0);
-            }
-        }
-        memmove(array + high + 1, array + high,
-                static_cast<size_t>((GetSize() - high)*sizeof(MappingType)));
-        array[high] = {key, value};
-    }
+    int index = KeyIndex(key, comparator);
+    // only support unique key
+    assert(index == GetSize() || comparator(key, array[index].first) != 0);
+    std::move_backward(array + index, array + GetSize(), array + GetSize() + 1);
+    array[index] = {key, value};
 
     IncreaseSize(1);
     assert(GetSize() <= GetMaxSize());
@@ -133,12 +126,12 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key,
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to "recipient" page, a new
+ * page chained in as the right sibling. Its first key is the high key of this
+ * page, it takes over the old one
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
-    BPlusTreeLeafPage *recipient,
-    __attribute__((unused)) BufferPoolManager *buffer_pool_manager) {
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
     // at least have some key-value pairs
     assert(GetSize() > 0);
 
@@ -146,6 +139,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(
     MappingType *src = array + GetSize() - size;
     recipient->CopyHalfFrom(src, size);
     IncreaseSize(-1*size);
+
+    recipient->SetNextPageId(GetNextPageId());
+    recipient->SetHighKey(GetHighKey());
+    SetNextPageId(recipient->GetPageId());
+    SetHighKey(recipient->KeyAt(0));
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -169,24 +167,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyHalfFrom(MappingType *items, int size) {
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
                                         const KeyComparator &comparator) const {
-    if (GetSize() == 0 || comparator(key, KeyAt(0)) < 0 ||
-        comparator(key, KeyAt(GetSize() - 1)) > 0) {
+    int index = KeyIndex(key, comparator);
+    if (index == GetSize() || comparator(key, array[index].first) != 0) {
         return false;
     }
-    // binary search
-    int low = 0, high = GetSize() - 1, mid;
-    while (low <= high) {
-        mid = low + (high - low)/2;
-        if (comparator(key, KeyAt(mid)) > 0) {
-            low = mid + 1;
-        } else if (comparator(key, KeyAt(mid)) < 0) {
-            high = mid - 1;
-        } else {
-            value = array[mid].second;
-            return true;
-        }
-    }
-    return false;
+    value = array[index].second;
+    return true;
 }
 
 /*****************************************************************************
@@ -201,26 +187,10 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
     const KeyType &key, const KeyComparator &comparator) {
-    if (GetSize() == 0 || comparator(key, KeyAt(0)) < 0 ||
-        comparator(key, KeyAt(GetSize() - 1)) > 0) {
-        return GetSize();
-    }
-
-    // binary search
-    int low = 0, high = GetSize() - 1, mid;
-    while (low <= high) {
-        mid = low + (high - low)/2;
-        if (comparator(key, KeyAt(mid)) > 0) {
-            low = mid + 1;
-        } else if (comparator(key, KeyAt(mid)) < 0) {
-            high = mid - 1;
-        } else {
-            // delete
-            memmove(array + mid, array + mid + 1,
-                    static_cast<size_t>((GetSize() - mid - 1)*sizeof(MappingType)));
-            IncreaseSize(-1);
-            break;
-        }
+    int index = KeyIndex(key, comparator);
+    if (index < GetSize() && comparator(key, array[index].first) == 0) {
+        std::move(array + index + 1, array + GetSize(), array + index);
+        IncreaseSize(-1);
     }
     return GetSize();
 }
@@ -229,14 +199,15 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
  * MERGE
  *****************************************************************************/
 /*
- * Remove all of key & value pairs from this page to "recipient" page, then
- * update next page id
+ * Remove all of key & value pairs from this page to "recipient" page, its left
+ * sibling, then update next page id and high key
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
-                                           int, BufferPoolManager *) {
+                                           const KeyType &) {
     recipient->CopyAllFrom(array, GetSize());
     recipient->SetNextPageId(GetNextPageId());
+    recipient->SetHighKey(GetHighKey());
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -253,32 +224,17 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyAllFrom(MappingType *items, int size) {
  * REDISTRIBUTE
  *****************************************************************************/
 /*
- * Remove the first key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Remove the first key & value pair from this page to "recipient" page, its
+ * left sibling. The caller updates the separator in the parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(
-    BPlusTreeLeafPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {
+    BPlusTreeLeafPage *recipient, const KeyType &) {
     MappingType pair = GetItem(0);
     IncreaseSize(-1);
-    memmove(array, array + 1, static_cast<size_t>(GetSize()*sizeof(MappingType)));
+    std::move(array + 1, array + GetSize() + 1, array);
 
     recipient->CopyLastFrom(pair);
-
-    auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while MoveFirstToEndOf");
-    }
-    // update relevant key & value pair in parent
-    auto parent = reinterpret_cast<BPlusTreeInternalPage<KeyType, decltype(GetPageId()),KeyComparator> *>(page->GetData());
-
-    // replace key in parent with the moving one
-    parent->SetKeyAt(parent->ValueIndex(GetPageId()), pair.first);
-
-    // unpin parent when we are done
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -288,40 +244,23 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
     IncreaseSize(1);
 }
 /*
- * Remove the last key & value pair from this page to "recipient" page, then
- * update relavent key & value pair in its parent page.
+ * Remove the last key & value pair from this page to "recipient" page, its
+ * right sibling. The caller updates the separator in the parent
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(
-    BPlusTreeLeafPage *recipient, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {
+    BPlusTreeLeafPage *recipient, const KeyType &) {
     MappingType pair = GetItem(GetSize() - 1);
     IncreaseSize(-1);
-    recipient->CopyFirstFrom(pair, parentIndex, buffer_pool_manager);
+    recipient->CopyFirstFrom(pair);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(
-    const MappingType &item, int parentIndex,
-    BufferPoolManager *buffer_pool_manager) {
-    assert(GetSize() + 1 < GetMaxSize());
-    memmove(array + 1, array, GetSize()*sizeof(MappingType));
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
+    assert(GetSize() + 1 <= GetMaxSize());
+    std::move_backward(array, array + GetSize(), array + GetSize() + 1);
     IncreaseSize(1);
     array[0] = item;
-
-    auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
-    if (page == nullptr) {
-        throw Exception(EXCEPTION_TYPE_INDEX,
-                        "all page are pinned while CopyFirstFrom");
-    }
-    // get parent
-    auto parent = reinterpret_cast<BPlusTreeInternalPage<KeyType, decltype(GetPageId()),KeyComparator> *>(page->GetData());
-
-    // replace with moving key
-    parent->SetKeyAt(parentIndex, item.first);
-
-    // unpin when are done
-    buffer_pool_manager->UnpinPage(GetParentPageId(), true);
 }
 
 /*****************************************************************************
@@ -334,7 +273,7 @@ std::string B_PLUS_TREE_LEAF_PAGE_TYPE::ToString(bool verbose) const {
   }
   std::ostringstream stream;
   if (verbose) {
-    stream << "[pageId: " << GetPageId() << " parentId: " << GetParentPageId()
+    stream << "[pageId: " << GetPageId() << " nextId: " << GetNextPageId()
            << "]<" << GetSize() << "> ";
   }
   int entry = 0;
@@ -366,4 +305,8 @@ template class BPlusTreeLeafPage<GenericKey<32>, RID,
                                        GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID,
                                        GenericComparator<64>>;
+template class BPlusTreeLeafPage<IntegerKey<int32_t>, RID,
+                                       IntegerComparator<int32_t>>;
+template class BPlusTreeLeafPage<IntegerKey<int64_t>, RID,
+                                       IntegerComparator<int64_t>>;
 } // namespace scudb
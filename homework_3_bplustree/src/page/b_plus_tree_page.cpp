@@ -14,9 +14,6 @@ bool BPlusTreePage::IsLeafPage() const {
         return true;
     return false;
 }
-bool BPlusTreePage::IsRootPage() const {
-    return parent_page_id_ == INVALID_PAGE_ID;
-}
 void BPlusTreePage::SetPageType(IndexPageType page_type) {
     page_type_ = page_type;
 }
@@ -57,13 +54,13 @@ int BPlusTreePage::GetMinSize() const {
 }
 
 /*
- * Helper methods to get/set parent page id
+ * Helper methods to get/set level, the height above the leaves
  */
-page_id_t BPlusTreePage::GetParentPageId() const {
-    return parent_page_id_;
+int BPlusTreePage::GetLevel() const {
+    return level_;
 }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {
-    parent_page_id_ = parent_page_id;
+void BPlusTreePage::SetLevel(int level) {
+    level_ = level;
 }
 
 /*
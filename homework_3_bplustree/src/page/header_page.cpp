@@ -8,6 +8,16 @@
 
 namespace scudb {
 
+const uint16_t HeaderPage::FREE_SPACE_MAP;
+const uint16_t HeaderPage::BLINK_PAGES;
+
+static const int PAGE_SIZE_OFFSET = 0;
+static const int FLAGS_OFFSET = 2;
+static const int POOL_SIZE_OFFSET = 4;
+static const int RECORD_COUNT_OFFSET = 8;
+static const int RECORDS_OFFSET = 12;
+static const int RECORD_SIZE = 36;
+
 /**
  * Record related
  */
@@ -17,7 +27,10 @@ bool HeaderPage::InsertRecord(const std::string &name,
   assert(root_id > INVALID_PAGE_ID);
 
   int record_num = GetRecordCount();
-  int offset = 4 + record_num * 36;
+  int offset = RECORDS_OFFSET + record_num * RECORD_SIZE;
+  // header page is full
+  if (offset + RECORD_SIZE > static_cast<int>(PAGE_SIZE))
+    return false;
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
@@ -37,9 +50,9 @@ bool HeaderPage::DeleteRecord(const std::string &name) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
-  memmove(GetData() + offset, GetData() + offset + 36,
-          (record_num - index - 1) * 36);
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET;
+  memmove(GetData() + offset, GetData() + offset + RECORD_SIZE,
+          (record_num - index - 1) * RECORD_SIZE);
 
   SetRecordCount(record_num - 1);
   return true;
@@ -53,7 +66,7 @@ bool HeaderPage::UpdateRecord(const std::string &name,
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = index * 36 + 4;
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET;
   // update record content, only root_id
   memcpy((GetData() + offset + 32), &root_id, 4);
 
@@ -67,27 +80,65 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   // record does not exsit
   if (index == -1)
     return false;
-  int offset = (index + 1) * 36;
+  int offset = index * RECORD_SIZE + RECORDS_OFFSET + 32;
   root_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
 
   return true;
 }
 
+/**
+ * Database configuration related
+ */
+size_t HeaderPage::GetPageSize() { return GetPageSize(GetData()); }
+
+void HeaderPage::SetPageSize(size_t page_size) {
+  uint16_t value = page_size;
+  memcpy(GetData() + PAGE_SIZE_OFFSET, &value, 2);
+}
+
+size_t HeaderPage::GetPoolSize() { return GetPoolSize(GetData()); }
+
+void HeaderPage::SetPoolSize(size_t pool_size) {
+  uint32_t value = pool_size;
+  memcpy(GetData() + POOL_SIZE_OFFSET, &value, 4);
+}
+
+uint16_t HeaderPage::GetFlags() { return GetFlags(GetData()); }
+
+void HeaderPage::SetFlags(uint16_t flags) {
+  memcpy(GetData() + FLAGS_OFFSET, &flags, 2);
+}
+
+size_t HeaderPage::GetPageSize(const char *data) {
+  return *reinterpret_cast<const uint16_t *>(data + PAGE_SIZE_OFFSET);
+}
+
+size_t HeaderPage::GetPoolSize(const char *data) {
+  return *reinterpret_cast<const uint32_t *>(data + POOL_SIZE_OFFSET);
+}
+
+uint16_t HeaderPage::GetFlags(const char *data) {
+  return *reinterpret_cast<const uint16_t *>(data + FLAGS_OFFSET);
+}
+
 /**
  * helper functions
  */
 // record count
-int HeaderPage::GetRecordCount() { return *reinterpret_cast<int *>(GetData()); }
+int HeaderPage::GetRecordCount() {
+  return *reinterpret_cast<int *>(GetData() + RECORD_COUNT_OFFSET);
+}
 
 void HeaderPage::SetRecordCount(int record_count) {
-  memcpy(GetData(), &record_count, 4);
+  memcpy(GetData() + RECORD_COUNT_OFFSET, &record_count, 4);
 }
 
 int HeaderPage::FindRecord(const std::string &name) {
   int record_num = GetRecordCount();
 
   for (int i = 0; i < record_num; i++) {
-    char *raw_name = reinterpret_cast<char *>(GetData() + (4 + i * 36));
+    char *raw_name =
+        reinterpret_cast<char *>(GetData() + (RECORDS_OFFSET + i * RECORD_SIZE));
     if (strcmp(raw_name, name.c_str()) == 0)
       return i;
   }
@@ -3,6 +3,7 @@
  */
 
 #include <cassert>
+#include <memory>
 
 #include "common/logger.h"
 #include "table/table_heap.h"
@@ -22,136 +23,122 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      Transaction *txn)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       log_manager_(log_manager) {
-  auto first_page =
-      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
-  assert(first_page != nullptr); // todo: abort table creation?
-  first_page->WLatch();
+  auto guard = buffer_pool_manager_->NewPageGuarded(first_page_id_);
+  assert(guard.IsValid()); // todo: abort table creation?
   LOG_DEBUG("new table page created %d", first_page_id_);
 
+  auto first_page = static_cast<TablePage *>(guard.GetPage());
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
-  first_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
 bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
-  if (tuple.size_ + 32 > PAGE_SIZE) { // larger than one page size
+  if (tuple.size_ + 32 > static_cast<int>(PAGE_SIZE)) { // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  auto guard = buffer_pool_manager_->FetchPageWrite(first_page_id_);
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  cur_page->WLatch();
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
   while (!cur_page->InsertTuple(
       tuple, rid, txn, lock_manager_,
       log_manager_)) { // fail to insert due to not enough space
     auto next_page_id = cur_page->GetNextPageId();
     if (next_page_id != INVALID_PAGE_ID) { // valid next page
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = static_cast<TablePage *>(
-          buffer_pool_manager_->FetchPage(next_page_id));
-      cur_page->WLatch();
+      guard = buffer_pool_manager_->FetchPageWrite(next_page_id);
+      if (!guard.IsValid()) {
+        txn->SetState(TransactionState::ABORTED);
+        return false;
+      }
+      cur_page = static_cast<TablePage *>(guard.GetPage());
     } else { // create new page
-      auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
-      if (new_page == nullptr) {
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
+      auto new_guard = buffer_pool_manager_->NewPageGuarded(next_page_id);
+      if (!new_guard.IsValid()) {
         txn->SetState(TransactionState::ABORTED);
         return false;
       }
-      new_page->WLatch();
       // std::cout << "new table page " << next_page_id << " created" <<
       // std::endl;
+      auto new_page = static_cast<TablePage *>(new_guard.GetPage());
       cur_page->SetNextPageId(next_page_id);
       new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetPageId(),
                      log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+      guard.SetDirty();
+      guard = std::move(new_guard);
       cur_page = new_page;
     }
   }
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+  guard.SetDirty();
+  guard.Release();
   txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   // todo: remove empty page
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  page->WLatch();
+  auto page = static_cast<TablePage *>(guard.GetPage());
   page->MarkDelete(rid, txn, lock_manager_, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  guard.SetDirty();
+  guard.Release();
   txn->GetWriteSet()->emplace_back(rid, WType::DELETE, Tuple{}, this);
   return true;
 }
 
 bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid,
                             Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
   Tuple old_tuple;
-  page->WLatch();
+  auto page = static_cast<TablePage *>(guard.GetPage());
   bool is_updated = page->UpdateTuple(tuple, old_tuple, rid, txn, lock_manager_,
                                       log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), is_updated);
+  if (is_updated) {
+    guard.SetDirty();
+  }
+  guard.Release();
   if (is_updated && txn->GetState() != TransactionState::ABORTED)
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   return is_updated;
 }
 
 void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
-  page->WLatch();
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
+  guard.SetDirty();
+  auto page = static_cast<TablePage *>(guard.GetPage());
   page->ApplyDelete(rid, txn, log_manager_);
   lock_manager_->Unlock(txn, rid);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
-  auto page = reinterpret_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  assert(page != nullptr);
-  page->WLatch();
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  assert(guard.IsValid());
+  guard.SetDirty();
+  auto page = static_cast<TablePage *>(guard.GetPage());
   page->RollbackDelete(rid, txn, log_manager_);
-  page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
 }
 
 // called by tuple iterator
 bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
-  auto page = static_cast<TablePage *>(
-      buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr) {
+  auto guard = buffer_pool_manager_->FetchPageRead(rid.GetPageId());
+  if (!guard.IsValid()) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
-  page->RLatch();
-  bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
-  return res;
+  auto page = static_cast<TablePage *>(guard.GetPage());
+  return page->GetTuple(rid, tuple, txn, lock_manager_);
 }
 
 bool TableHeap::DeleteTableHeap() {
@@ -159,17 +146,23 @@ bool TableHeap::DeleteTableHeap() {
   return true;
 }
 
+// a sequential scan reads through a small ring of frames of its own, so it
+// does not push the rest of the working set out of the buffer pool
 TableIterator TableHeap::begin(Transaction *txn) {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  page->RLatch();
+  auto strategy = std::make_shared<BufferAccessStrategy>();
   RID rid;
-  // if failed (no tuple), rid will be the result of default
-  // constructor, which means eof
-  page->GetFirstTupleRid(rid);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
-  return TableIterator(this, rid, txn);
+  {
+    auto guard =
+        buffer_pool_manager_->FetchPageRead(first_page_id_, strategy.get());
+    auto page = static_cast<TablePage *>(guard.GetPage());
+    // if failed (no tuple), rid will be the result of default
+    // constructor, which means eof
+    page->GetFirstTupleRid(rid);
+    // read the next page while the first one is scanned
+    buffer_pool_manager_->PrefetchPages({page->GetNextPageId()},
+                                        strategy.get());
+  }
+  return TableIterator(this, rid, txn, strategy);
 }
 
 TableIterator TableHeap::end() {
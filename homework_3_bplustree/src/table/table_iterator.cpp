@@ -8,8 +8,10 @@
 
 namespace scudb {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
@@ -27,33 +29,33 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(
-      buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr); // all pages are pinned
+  auto guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(),
+                                                  strategy_.get());
+  assert(guard.IsValid()); // all pages are pinned
+  auto cur_page = static_cast<TablePage *>(guard.GetPage());
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  next_tuple_rid)) { // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(
-          buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      // the next page is latched before the current one is released
+      guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId(),
+                                                 strategy_.get());
+      assert(guard.IsValid());
+      cur_page = static_cast<TablePage *>(guard.GetPage());
+      // read ahead the page after, it loads while this one is scanned
+      buffer_pool_manager->PrefetchPages({cur_page->GetNextPageId()},
+                                         strategy_.get());
       if (cur_page->GetFirstTupleRid(next_tuple_rid))
         break;
     }
   }
   tuple_->rid_ = next_tuple_rid;
 
+  // copy the tuple out of the page we hold, before releasing it
   if (*this != table_heap_->end()) {
-    table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
+    cur_page->GetTuple(tuple_->rid_, *tuple_, txn_, table_heap_->lock_manager_);
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetPageId(), false);
   return *this;
 }
 
@@ -17,9 +17,119 @@ namespace scudb {
 
 SQLITE_EXTENSION_INIT1
 
+/*
+ * Module arguments after the schema: the index definition, and optionally
+ * page_size=<bytes> and pool_size=<frames> to size the storage engine, and
+ * direct_io=1 to open it with direct I/O. Each of them may be quoted
+ */
+static bool ParseModuleArguments(int argc, const char *const *argv,
+                                 std::string &index_string, size_t &page_size,
+                                 size_t &pool_size, size_t &direct_io,
+                                 char **pzErr) {
+  for (int i = 4; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.size() >= 2 && (arg[0] == '\'' || arg[0] == '"'))
+      arg = arg.substr(1, arg.size() - 2);
+    size_t *option = nullptr;
+    if (arg.compare(0, 10, "page_size=") == 0)
+      option = &page_size;
+    else if (arg.compare(0, 10, "pool_size=") == 0)
+      option = &pool_size;
+    else if (arg.compare(0, 10, "direct_io=") == 0)
+      option = &direct_io;
+    if (option == nullptr) {
+      index_string = arg;
+      continue;
+    }
+    try {
+      *option = std::stoul(arg.substr(10));
+    } catch (std::exception &e) {
+      *pzErr = sqlite3_mprintf("invalid argument %s", arg.c_str());
+      return false;
+    }
+  }
+  if (page_size != 0 && !StorageEngine::IsValidPageSize(page_size)) {
+    *pzErr = sqlite3_mprintf("page_size must be a power of two from %d to %d",
+                             MIN_PAGE_SIZE, MAX_PAGE_SIZE);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * The storage engine is built for the first table created or connected, so
+ * that its arguments can size it: a new database gets the requested page
+ * size, an existing one keeps the page size in its header page, which also
+ * records the pool size. Later tables can not change the page size.
+ */
+static bool OpenStorageEngine(size_t page_size, size_t pool_size,
+                              size_t direct_io, char **pzErr) {
+  if (storage_engine_ == nullptr) {
+    std::string db_file_name = "vtable.db";
+    struct stat buffer;
+    bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
+
+    // init storage engine
+    storage_engine_ = new StorageEngine(db_file_name, page_size, pool_size,
+                                        direct_io != 0);
+    // start the logging
+    storage_engine_->log_manager_->RunFlushThread();
+    // create header page from BufferPoolManager if necessary
+    BufferPoolManager *buffer_pool_manager =
+        storage_engine_->buffer_pool_manager_;
+    HeaderPage *header_page;
+    if (!is_file_exist) {
+      page_id_t header_page_id;
+      header_page =
+          static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
+      assert(header_page_id == HEADER_PAGE_ID);
+      header_page->Init(
+          (storage_engine_->free_space_map_ ? HeaderPage::FREE_SPACE_MAP : 0) |
+          (storage_engine_->blink_pages_ ? HeaderPage::BLINK_PAGES : 0));
+    } else {
+      header_page = static_cast<HeaderPage *>(
+          buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+      header_page->SetPoolSize(BUFFER_POOL_SIZE);
+    }
+    buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+  }
+  if (page_size != 0 && page_size != PAGE_SIZE) {
+    *pzErr = sqlite3_mprintf("database page size is %d", (int)PAGE_SIZE);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Index pages are read in the B-link layout, a database created before it
+ * has index pages that would be misread. Its indexes are refused, and so are
+ * new ones, which could not be told apart from the old ones once reopened.
+ * Tables without an index still work
+ */
+static bool CheckIndexLayout(const std::string &index_string, char **pzErr) {
+  if (!index_string.empty() && !storage_engine_->blink_pages_) {
+    *pzErr = sqlite3_mprintf("indexes of this database have an older page "
+                             "layout, rebuild it to use them");
+    return false;
+  }
+  return true;
+}
+
 /* API implementation */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr) {
+  // the first three parameter:(1) module name (2) database name (3)table name
+  assert(argc >= 4);
+  std::string index_string;
+  size_t page_size = 0;
+  size_t pool_size = 0;
+  size_t direct_io = 0;
+  if (!ParseModuleArguments(argc, argv, index_string, page_size, pool_size,
+                            direct_io, pzErr) ||
+      !OpenStorageEngine(page_size, pool_size, direct_io, pzErr) ||
+      !CheckIndexLayout(index_string, pzErr))
+    return SQLITE_ERROR;
+
   BufferPoolManager *buffer_pool_manager =
       storage_engine_->buffer_pool_manager_;
   LockManager *lock_manager = storage_engine_->lock_manager_;
@@ -29,8 +139,6 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   HeaderPage *header_page =
       static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
 
-  // the first three parameter:(1) module name (2) database name (3)table name
-  assert(argc >= 4);
   // parse arg[3](string that defines table schema)
   std::string schema_string(argv[3]);
   schema_string = schema_string.substr(1, (schema_string.size() - 2));
@@ -38,9 +146,7 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
-    index_string = index_string.substr(1, (index_string.size() - 2));
+  if (!index_string.empty()) {
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
@@ -65,6 +171,16 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
 int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                 sqlite3_vtab **ppVtab, char **pzErr) {
   assert(argc >= 4);
+  std::string index_string;
+  size_t page_size = 0;
+  size_t pool_size = 0;
+  size_t direct_io = 0;
+  if (!ParseModuleArguments(argc, argv, index_string, page_size, pool_size,
+                            direct_io, pzErr) ||
+      !OpenStorageEngine(page_size, pool_size, direct_io, pzErr) ||
+      !CheckIndexLayout(index_string, pzErr))
+    return SQLITE_ERROR;
+
   std::string schema_string(argv[3]);
   // remove the very first and last character
   schema_string = schema_string.substr(1, (schema_string.size() - 2));
@@ -83,14 +199,12 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   header_page->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
-    index_string = index_string.substr(1, (index_string.size() - 2));
+  if (!index_string.empty()) {
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    // Retrieve index root page info from header page
-    page_id_t index_root_id;
+    // Retrieve index root page info from header page, none if still empty
+    page_id_t index_root_id = INVALID_PAGE_ID;
     header_page->GetRootId(index_metadata->GetName(), index_root_id);
     index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
   }
@@ -153,6 +267,7 @@ int VtabDisconnect(sqlite3_vtab *pVtab) {
   delete virtual_table;
   // delete all the global managers
   delete storage_engine_;
+  storage_engine_ = nullptr;
   return SQLITE_OK;
 }
 
@@ -322,6 +437,126 @@ int VtabCommit(sqlite3_vtab *pVTab) {
   return SQLITE_OK;
 }
 
+/*
+ * scudb_buffer_stats has no xCreate, so it is eponymous: it exists in every
+ * database once the extension is loaded. It reads the stats when a scan
+ * starts, and is empty while no storage engine is open
+ */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr) {
+  int rc = sqlite3_declare_vtab(db, "CREATE TABLE x(name TEXT, value)");
+  if (rc != SQLITE_OK)
+    return rc;
+  *ppVtab = new sqlite3_vtab();
+  return SQLITE_OK;
+}
+
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  pIdxInfo->estimatedCost = 100;
+  return SQLITE_OK;
+}
+
+int StatsDisconnect(sqlite3_vtab *pVtab) {
+  delete pVtab;
+  return SQLITE_OK;
+}
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  StatsCursor *cursor = new StatsCursor();
+  *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(cursor);
+  return SQLITE_OK;
+}
+
+int StatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<StatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(pVtabCursor);
+  cursor->Clear();
+  if (storage_engine_ != nullptr) {
+    BufferPoolManager *buffer_pool_manager =
+        storage_engine_->buffer_pool_manager_;
+    cursor->Load(buffer_pool_manager->GetStats(),
+                 buffer_pool_manager->GetPoolSize(),
+                 buffer_pool_manager->GetMemoryUsage());
+  }
+  return SQLITE_OK;
+}
+
+int StatsNext(sqlite3_vtab_cursor *cur) {
+  reinterpret_cast<StatsCursor *>(cur)->Next();
+  return SQLITE_OK;
+}
+
+int StatsEof(sqlite3_vtab_cursor *cur) {
+  return reinterpret_cast<StatsCursor *>(cur)->isEof();
+}
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(cur);
+  if (i == 0)
+    sqlite3_result_text(ctx, cursor->GetName().c_str(), -1, SQLITE_TRANSIENT);
+  else if (cursor->IsReal())
+    sqlite3_result_double(ctx, cursor->GetRealValue());
+  else
+    sqlite3_result_int64(ctx, cursor->GetIntValue());
+  return SQLITE_OK;
+}
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<StatsCursor *>(cur)->GetOffset();
+  return SQLITE_OK;
+}
+
+void StatsCursor::Load(const BufferPoolStats &stats, size_t pool_size,
+                       size_t memory_bytes) {
+  AddRow("pool_size", static_cast<uint64_t>(pool_size));
+  AddRow("memory_bytes", static_cast<uint64_t>(memory_bytes));
+  for (int i = 0; i < static_cast<int>(StatCounter::NUM_COUNTERS); i++) {
+    StatCounter counter = static_cast<StatCounter>(i);
+    AddRow(BufferPoolStats::GetName(counter), stats.Get(counter));
+  }
+  AddRow("hit_ratio", stats.HitRatio());
+  for (int i = 0; i < static_cast<int>(StatLatency::NUM_LATENCIES); i++) {
+    StatLatency latency = static_cast<StatLatency>(i);
+    std::string name = BufferPoolStats::GetName(latency);
+    const LatencyHistogram &histogram = stats.Get(latency);
+    AddRow(name + "_count", histogram.count);
+    AddRow(name + "_mean_ns", histogram.MeanNs());
+    AddRow(name + "_p50_ns", histogram.PercentileNs(0.5));
+    AddRow(name + "_p99_ns", histogram.PercentileNs(0.99));
+  }
+}
+
+sqlite3_module BufferStatsModule = {
+    0,               /* iVersion */
+    0,               /* xCreate - eponymous only */
+    StatsConnect,    /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    StatsDisconnect, /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate - read only */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
 sqlite3_module VtableModule = {
     0,              /* iVersion */
     VtabCreate,     /* xCreate */
@@ -354,24 +589,13 @@ __declspec(dllexport)
     extern "C" int sqlite3_vtable_init(sqlite3 *db, char **pzErrMsg,
                                        const sqlite3_api_routines *pApi) {
   SQLITE_EXTENSION_INIT2(pApi);
-  std::string db_file_name = "vtable.db";
-  struct stat buffer;
-  bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
-
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
-  // start the logging
-  storage_engine_->log_manager_->RunFlushThread();
-  // create header page from BufferPoolManager if necessary
-  if (!is_file_exist) {
-    page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
-
-    assert(header_page_id == HEADER_PAGE_ID);
-    storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
-  }
-
+  // the storage engine is opened with the first virtual table, whose module
+  // arguments may size it
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc != SQLITE_OK)
+    return rc;
+  rc = sqlite3_create_module(db, "scudb_buffer_stats", &BufferStatsModule,
+                             nullptr);
   return rc;
 }
 
@@ -462,8 +686,10 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   if ((int)key_attrs.size() > schema->GetColumnCount())
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
+  // keys of virtual table indexes compare with memcmp, every index that can
+  // be opened has B-link pages, which are newer than normalized keys
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, true);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -510,6 +736,19 @@ Index *ConstructIndex(IndexMetadata *metadata,
                       page_id_t root_id) {
   // The size of the key in bytes
   Schema *key_schema = metadata->GetKeySchema();
+  // a single integer column is compared natively
+  if (key_schema->GetColumnCount() == 1 &&
+      key_schema->GetType(0) == TypeId::INTEGER) {
+    return new BPlusTreeIndex<IntegerKey<int32_t>, RID,
+                              IntegerComparator<int32_t>>(
+        metadata, buffer_pool_manager, root_id);
+  }
+  if (key_schema->GetColumnCount() == 1 &&
+      key_schema->GetType(0) == TypeId::BIGINT) {
+    return new BPlusTreeIndex<IntegerKey<int64_t>, RID,
+                              IntegerComparator<int64_t>>(
+        metadata, buffer_pool_manager, root_id);
+  }
   int key_size = key_schema->GetLength();
   // for each varchar attribute, we assume the largest size is 16 bytes
   key_size += 16 * key_schema->GetUnlinedColumnCount();
@@ -2,7 +2,13 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -48,4 +54,752 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ReplacerPolicyTest) {
+  for (auto replacer_type : {ReplacerType::LRU, ReplacerType::LRU_K}) {
+    page_id_t temp_page_id;
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager bpm(5, disk_manager, nullptr, replacer_type);
+
+    for (int i = 0; i < 5; ++i) {
+      auto page = bpm.NewPage(temp_page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    }
+    // page 0 is used again after being unpinned
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, true));
+    }
+    EXPECT_NE(nullptr, bpm.FetchPage(0));
+    EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+    // new pages evict every unpinned page, dirty ones are written back
+    for (int i = 5; i < 10; ++i) {
+      EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+    }
+    EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+    for (int i = 5; i < 10; ++i) {
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    // evicted dirty pages come back with their content
+    for (int i = 0; i < 5; ++i) {
+      auto page = bpm.FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    }
+
+    delete disk_manager;
+    remove("test.db");
+  }
+}
+
+TEST(BufferPoolManagerTest, ConcurrentMissTest) {
+  const int num_threads = 4;
+  const int num_pages = 30;
+  const int num_rounds = 200;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(5, disk_manager);
+
+  // far more pages than frames, every fetch below is likely to miss
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // threads fetch overlapping pages and unpin them dirty, so victims are
+  // written back while other threads may already fetch them again
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid]() {
+      for (int round = 0; round < num_rounds; ++round) {
+        page_id_t page_id = (round * 7 + tid) % num_pages;
+        auto page = bpm.FetchPage(page_id);
+        if (page == nullptr) {
+          // all the frames are pinned by the other threads
+          continue;
+        }
+        EXPECT_EQ("page " + std::to_string(page_id),
+                  std::string(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const int num_pages = 10;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_pages, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // with a zero watermark every dirty unpinned frame gets written back
+  bpm.RunCleanerThread(0.0);
+  char data[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    bool written = false;
+    for (int retry = 0; retry < 100 && !written; ++retry) {
+      disk_manager->ReadPage(i, data);
+      written = std::string(data) == "page " + std::to_string(i);
+      if (!written) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }
+    EXPECT_EQ(true, written);
+  }
+
+  // pages stay resident and usable while the cleaner runs
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  bpm.StopCleanerThread();
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  const int num_pages = 10;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_pages, disk_manager);
+
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    // page 4 stays clean and splits the dirty pages in two runs
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, i != 4));
+  }
+
+  FlushStats stats = bpm.FlushAllPages();
+  EXPECT_EQ(num_pages - 1, stats.num_pages);
+  EXPECT_EQ((num_pages - 1) * PAGE_SIZE, stats.num_bytes);
+  EXPECT_EQ(2, stats.num_writes);
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(9, data);
+  EXPECT_EQ("page 9", std::string(data));
+
+  // nothing left to write, clean pages are not flushed again
+  stats = bpm.FlushAllPages();
+  EXPECT_EQ(0, stats.num_pages);
+  EXPECT_EQ(0, stats.num_writes);
+  EXPECT_EQ(true, bpm.FlushPage(0));
+
+  auto page = bpm.FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "page 3 again");
+  EXPECT_EQ(true, bpm.UnpinPage(3, true));
+  stats = bpm.FlushAllPages();
+  EXPECT_EQ(1, stats.num_pages);
+  disk_manager->ReadPage(3, data);
+  EXPECT_EQ("page 3 again", std::string(data));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PrefetchPagesTest) {
+  const int num_frames = 10;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_frames, disk_manager);
+
+  for (int i = 0; i < 2 * num_frames; ++i) {
+    page_id_t page_id;
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // pages 0-9 are on disk only, 10-19 are resident and become clean
+  bpm.FlushAllPages();
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_frames; ++i) {
+    page_ids.push_back(i);
+  }
+  bpm.PrefetchPages(page_ids);
+  // prefetched pages are not pinned, fetching them waits for the reads
+  for (int i = 0; i < num_frames; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+    EXPECT_EQ(false, bpm.UnpinPage(i, false));
+  }
+  for (int i = 0; i < num_frames; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, ScanRingTest) {
+  const int num_frames = 10;
+  const int num_hot_pages = 4;
+  const int num_scan_pages = 30;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(num_frames, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < num_hot_pages + num_scan_pages; ++i) {
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  bpm.FlushAllPages();
+  for (int i = 0; i < num_hot_pages; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // scan the other pages through a ring of 2 frames
+  BufferAccessStrategy strategy(2);
+  for (int i = num_hot_pages; i < num_hot_pages + num_scan_pages; ++i) {
+    auto page = bpm.FetchPage(i, &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  // the hot pages were never evicted: overwriting them on disk does not
+  // change what the buffer pool returns
+  char data[PAGE_SIZE];
+  snprintf(data, PAGE_SIZE, "stale");
+  for (int i = 0; i < num_hot_pages; ++i) {
+    disk_manager->WritePage(i, data);
+  }
+  for (int i = 0; i < num_hot_pages; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, ResizePoolTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(5, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+
+  // grown frames are free, new pages do not evict anything
+  EXPECT_EQ(true, bpm.ResizePool(8));
+  EXPECT_EQ(8, bpm.GetPoolSize());
+  for (int i = 5; i < 8; ++i) {
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  for (int i = 1; i < 8; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+
+  // dirty frames are written back on shrink, pinned page 0 stays
+  EXPECT_EQ(true, bpm.ResizePool(2));
+  EXPECT_EQ(2, bpm.GetPoolSize());
+  EXPECT_EQ(false, bpm.ResizePool(0));
+  EXPECT_EQ(1, bpm.GetPoolSize());
+  EXPECT_EQ(nullptr, bpm.FetchPage(3));
+  EXPECT_EQ(true, bpm.UnpinPage(0, true));
+  for (int i = 0; i < 8; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+
+  EXPECT_EQ(true, bpm.ResizePool(4));
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, bpm.FetchPage(i));
+  }
+  EXPECT_EQ(nullptr, bpm.FetchPage(4));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PageGuardTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  page_id_t page_id;
+  {
+    auto guard = bpm.NewPageGuarded(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ(1, guard.GetPage()->GetPinCount());
+    snprintf(guard.GetData(), PAGE_SIZE, "guarded");
+  }
+  {
+    auto guard = bpm.FetchPageRead(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    // a moved guard keeps the one pin of the fetch
+    ReadPageGuard moved = std::move(guard);
+    EXPECT_EQ(false, guard.IsValid());
+    EXPECT_EQ(1, moved.GetPage()->GetPinCount());
+    EXPECT_EQ("guarded", std::string(moved.GetData()));
+    // readers share the latch
+    auto other = bpm.FetchPageRead(page_id);
+    EXPECT_EQ(2, other.GetPage()->GetPinCount());
+  }
+  // every guard released its pin: the page is unpinned, dirty, and can be
+  // evicted by new pages and read back
+  EXPECT_EQ(false, bpm.UnpinPage(page_id, false));
+  for (int i = 0; i < 2; ++i) {
+    page_id_t temp_page_id;
+    auto guard = bpm.NewPageGuarded(temp_page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    guard.Release();
+    EXPECT_EQ(false, guard.IsValid());
+  }
+  {
+    auto guard = bpm.FetchPageWrite(page_id);
+    ASSERT_EQ(true, guard.IsValid());
+    EXPECT_EQ("guarded", std::string(guard.GetData()));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, UnpinFrameTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  page_id_t page_id;
+  Page *page = bpm.NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ(page, bpm.FetchPage(page_id));
+  snprintf(page->GetData(), PAGE_SIZE, "unpinned");
+  // the dirty flag of an unpin that is not the last one is kept
+  EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_EQ(false, bpm.UnpinPage(page, false));
+  EXPECT_EQ(2, bpm.GetStats().Get(StatCounter::UNPIN));
+
+  // the last unpin made the frame evictable, the page was written back
+  for (int i = 0; i < 2; ++i) {
+    page_id_t temp_page_id;
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, false));
+  }
+  page = bpm.FetchPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("unpinned", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, PageTableHitTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager, nullptr, ReplacerType::LRU_K);
+  page_id_t page_id;
+  // page 0 is hit while pinned, 1 and 2 are only created
+  Page *page = bpm.NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "hit");
+  ASSERT_EQ(page, bpm.FetchPage(0));
+  EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  EXPECT_EQ(true, bpm.UnpinPage(page, true));
+  for (int i = 1; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+
+  // the hit reached LRU-K: page 0 has two accesses, pages 1 and 2 go first
+  ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  std::vector<page_id_t> resident = bpm.GetResidentPages();
+  EXPECT_NE(resident.end(), std::find(resident.begin(), resident.end(), 0));
+  EXPECT_EQ(resident.end(), std::find(resident.begin(), resident.end(), 1));
+
+  // an unpinned page is pinned by a hit as well, and is then no victim
+  ASSERT_EQ(page, bpm.FetchPage(0));
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(0, bpm.GetStats().Get(StatCounter::FETCH_MISS));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(0, page->GetPageId());
+  EXPECT_EQ("hit", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm.UnpinPage(page, false));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // page 0 was evicted dirty by page 2, page 1 is resident
+  ASSERT_NE(nullptr, bpm.FetchPage(1));
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  EXPECT_EQ(nullptr, bpm.NewPage(page_id));
+
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(3, stats.Get(StatCounter::NEW_PAGE));
+  EXPECT_EQ(3, stats.Get(StatCounter::UNPIN));
+  EXPECT_EQ(1, stats.Get(StatCounter::FETCH_HIT));
+  EXPECT_EQ(1, stats.Get(StatCounter::FETCH_MISS));
+  EXPECT_EQ(0.5, stats.HitRatio());
+  EXPECT_EQ(2, stats.Get(StatCounter::EVICTION));
+  EXPECT_EQ(2, stats.Get(StatCounter::DIRTY_EVICTION));
+  EXPECT_EQ(1, stats.Get(StatCounter::NO_FREE_FRAME));
+  EXPECT_EQ(1, stats.Get(StatCounter::DISK_READ));
+  EXPECT_EQ(2, stats.Get(StatCounter::DISK_WRITE));
+  const LatencyHistogram &fetches = stats.Get(StatLatency::FETCH_PAGE);
+  EXPECT_EQ(2, fetches.count);
+  EXPECT_LE(fetches.PercentileNs(0.5), fetches.PercentileNs(0.99));
+  EXPECT_LE(fetches.MeanNs(), fetches.PercentileNs(1));
+  EXPECT_EQ(1, stats.Get(StatLatency::DISK_READ).count);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, OptimisticFetchTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(2, disk_manager);
+  page_id_t page_id_0, page_id_1, page_id_2;
+  Page *frame_0 = bpm->NewPage(page_id_0);
+  Page *frame_1 = bpm->NewPage(page_id_1);
+  ASSERT_NE(nullptr, frame_0);
+  ASSERT_NE(nullptr, frame_1);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_0, false));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_1, false));
+
+  // optimistic reads neither pin nor latch, writers fail them
+  uint64_t version;
+  EXPECT_EQ(frame_0, bpm->FetchPageOptimistic(page_id_0, version));
+  EXPECT_EQ(0, frame_0->GetPinCount());
+  EXPECT_TRUE(frame_0->ValidateLatch(version));
+  frame_0->WLatch();
+  uint64_t latched_version;
+  EXPECT_EQ(nullptr, bpm->FetchPageOptimistic(page_id_0, latched_version));
+  frame_0->WUnlatch();
+  EXPECT_FALSE(frame_0->ValidateLatch(version));
+
+  // a swizzled reference is followed while the frame holds the page
+  frame_1->Swizzle(3, frame_0);
+  EXPECT_EQ(frame_0, frame_1->GetSwizzled(3));
+  EXPECT_EQ(nullptr, frame_1->GetSwizzled(4));
+  EXPECT_EQ(frame_0,
+            bpm->FetchPageOptimistic(page_id_0, version, frame_1->GetSwizzled(3)));
+
+  // ...and stale once the page is evicted, page 0 is the lru victim
+  Page *frame_2 = bpm->NewPage(page_id_2);
+  ASSERT_EQ(frame_0, frame_2);
+  EXPECT_FALSE(frame_0->ValidateLatch(version));
+  EXPECT_EQ(nullptr,
+            bpm->FetchPageOptimistic(page_id_0, version, frame_1->GetSwizzled(3)));
+  EXPECT_EQ(frame_1, bpm->FetchPageOptimistic(page_id_1, version, frame_0));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_2, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, VictimCacheTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(2, disk_manager);
+  bpm.EnableVictimCache(4 * PAGE_SIZE);
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // page 0 was evicted by page 2, it comes back from the victim cache
+  EXPECT_LT(0, bpm.GetVictimCacheSize());
+  Page *page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 0"));
+  EXPECT_EQ(true, bpm.UnpinPage(0, false));
+
+  BufferPoolStats stats = bpm.GetStats();
+  EXPECT_EQ(1, stats.Get(StatCounter::VICTIM_CACHE_HIT));
+  EXPECT_EQ(0, stats.Get(StatCounter::VICTIM_CACHE_MISS));
+  EXPECT_EQ(0, stats.Get(StatCounter::DISK_READ));
+
+  // page 1 made room for it, without room left misses go to the disk
+  bpm.EnableVictimCache(0);
+  EXPECT_EQ(0, bpm.GetVictimCacheSize());
+  page = bpm.FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 1"));
+  EXPECT_EQ(true, bpm.UnpinPage(1, false));
+  stats = bpm.GetStats();
+  EXPECT_EQ(1, stats.Get(StatCounter::VICTIM_CACHE_MISS));
+  EXPECT_EQ(1, stats.Get(StatCounter::DISK_READ));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+
+  // pinned first, then from the most recently used
+  std::vector<page_id_t> resident = bpm->GetResidentPages();
+  EXPECT_EQ(std::vector<page_id_t>({2, 1, 3, 0}), resident);
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // a smaller pool only takes the hottest ones
+  bpm = new BufferPoolManager(2, disk_manager);
+  bpm->WarmUp(resident);
+  for (page_id_t hot : {2, 1}) {
+    Page *page = bpm->FetchPage(hot);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(hot), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(hot, false));
+  }
+  BufferPoolStats stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.Get(StatCounter::FETCH_HIT));
+  EXPECT_EQ(0, stats.Get(StatCounter::FETCH_MISS));
+  delete bpm;
+
+  // a page left out of a full warm-up waits for a prefetched frame
+  bpm = new BufferPoolManager(2, disk_manager);
+  bpm->WarmUp(resident);
+  Page *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page 0", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// frames are aligned for O_DIRECT, unaligned buffers work too
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  DiskManager *disk_manager = new DiskManager("test.db", true);
+  BufferPoolManager bpm(2, disk_manager);
+  EXPECT_LE(2 * PAGE_SIZE, bpm.GetMemoryUsage());
+  page_id_t page_id;
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  for (page_id_t i = 0; i < 4; ++i) {
+    Page *page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  bpm.FlushAllPages();
+
+  std::vector<char> buffer(PAGE_SIZE + 1);
+  disk_manager->ReadPage(1, buffer.data() + 1);
+  EXPECT_EQ("page 1", std::string(buffer.data() + 1));
+  snprintf(buffer.data() + 1, PAGE_SIZE, "page 5");
+  disk_manager->WritePage(5, buffer.data() + 1);
+  // past the end of the file, a page reads as zeros
+  disk_manager->ReadPage(6, buffer.data() + 1);
+  EXPECT_EQ(std::string(PAGE_SIZE, '\0'),
+            std::string(buffer.data() + 1, PAGE_SIZE));
+  disk_manager->ReadPage(5, buffer.data() + 1);
+  EXPECT_EQ("page 5", std::string(buffer.data() + 1));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// deleted pages are allocated again, also after a restart
+TEST(BufferPoolManagerTest, FreeSpaceMapTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  bpm->EnableFreeSpaceMap();
+  page_id_t page_id;
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    page_ids.push_back(page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  // the first bitmap page comes after the header page
+  EXPECT_EQ((std::vector<page_id_t>{0, 2, 3, 4, 5}), page_ids);
+  EXPECT_EQ(true, bpm->DeletePage(4));
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(2, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  bpm = new BufferPoolManager(10, disk_manager);
+  bpm->EnableFreeSpaceMap();
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(4, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(6, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a deleted page read back into the pool, by a late reader, leaves the frame
+// of the page allocated with its id as the only one
+TEST(BufferPoolManagerTest, FreeSpaceMapStaleCopyTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  bpm->EnableFreeSpaceMap();
+  page_id_t page_id;
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(4));
+  Page *stale = bpm->FetchPage(4);
+  ASSERT_NE(nullptr, stale);
+  EXPECT_EQ(true, bpm->UnpinPage(4, false));
+
+  Page *page = bpm->NewPage(page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(4, page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "new page 4");
+  // cycle the other frames, the stale copy goes away if still there
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(page, bpm->FetchPage(4));
+  EXPECT_EQ("new page 4", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(4, true));
+  EXPECT_EQ(true, bpm->UnpinPage(4, true));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+
+// a page deleted while pinned is freed on its last unpin, a page evicted
+// before it is deleted is freed as well
+TEST(BufferPoolManagerTest, DeletePinnedPageTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManager(3, disk_manager);
+  bpm->EnableFreeSpaceMap();
+  page_id_t page_id;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(3, page_id);
+
+  Page *page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  // still readable by whoever pins it
+  EXPECT_EQ(2, page->GetPageId());
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(4, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(2, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+
+  // page 3 is no longer resident
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(3));
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(3, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(false, bpm->DeletePage(INVALID_PAGE_ID));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace scudb
@@ -0,0 +1,94 @@
+/**
+ * compressed_page_cache_test.cpp
+ */
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "buffer/compressed_page_cache.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(CompressedPageCacheTest, CompressTest) {
+  std::vector<char> page(PAGE_SIZE, 0);
+  std::vector<char> compressed(PAGE_SIZE);
+  std::vector<char> restored(PAGE_SIZE);
+
+  // a zeroed page takes a few bytes
+  size_t size =
+      CompressedPageCache::Compress(page.data(), PAGE_SIZE, compressed.data(),
+                                    PAGE_SIZE);
+  ASSERT_NE(0u, size);
+  EXPECT_LT(size, 64u);
+  restored[0] = 1;
+  EXPECT_TRUE(CompressedPageCache::Decompress(compressed.data(), size,
+                                              restored.data(), PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page.data(), restored.data(), PAGE_SIZE));
+
+  // repeated records with a random tail
+  std::mt19937 rng(7);
+  for (size_t i = 0; i < PAGE_SIZE / 2; ++i) {
+    page[i] = "key_0000"[i % 8] + (i / 64) % 4;
+  }
+  for (size_t i = PAGE_SIZE / 2; i < PAGE_SIZE; ++i) {
+    page[i] = static_cast<char>(rng());
+  }
+  size = CompressedPageCache::Compress(page.data(), PAGE_SIZE,
+                                       compressed.data(), PAGE_SIZE);
+  ASSERT_NE(0u, size);
+  EXPECT_TRUE(CompressedPageCache::Decompress(compressed.data(), size,
+                                              restored.data(), PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page.data(), restored.data(), PAGE_SIZE));
+  EXPECT_FALSE(CompressedPageCache::Decompress(compressed.data(), size - 1,
+                                               restored.data(), PAGE_SIZE));
+
+  // random bytes do not fit in less than a page
+  for (size_t i = 0; i < PAGE_SIZE; ++i) {
+    page[i] = static_cast<char>(rng());
+  }
+  EXPECT_EQ(0u, CompressedPageCache::Compress(page.data(), PAGE_SIZE,
+                                             compressed.data(), PAGE_SIZE - 1));
+}
+
+TEST(CompressedPageCacheTest, SampleTest) {
+  std::vector<char> page(PAGE_SIZE, 0);
+  std::vector<char> restored(PAGE_SIZE);
+  CompressedPageCache cache(PAGE_SIZE);
+  snprintf(page.data(), PAGE_SIZE, "page 0");
+  cache.Insert(0, page.data());
+  snprintf(page.data(), PAGE_SIZE, "page 1");
+  cache.Insert(1, page.data());
+  EXPECT_EQ(2u, cache.GetNumPages());
+  size_t size = cache.GetSize();
+
+  // a later copy replaces the one held
+  snprintf(page.data(), PAGE_SIZE, "page 0 again");
+  cache.Insert(0, page.data());
+  EXPECT_EQ(2u, cache.GetNumPages());
+
+  // a hit moves the page out of the cache
+  EXPECT_TRUE(cache.Take(0, restored.data()));
+  EXPECT_EQ(0, strcmp(restored.data(), "page 0 again"));
+  EXPECT_FALSE(cache.Take(0, restored.data()));
+  cache.Erase(1);
+  EXPECT_EQ(0u, cache.GetNumPages());
+  EXPECT_EQ(0u, cache.GetSize());
+
+  // the pages evicted longest ago make room
+  cache.SetCapacity(size);
+  page.assign(PAGE_SIZE, 0);
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    snprintf(page.data(), PAGE_SIZE, "page %d", page_id);
+    cache.Insert(page_id, page.data());
+  }
+  EXPECT_EQ(2u, cache.GetNumPages());
+  EXPECT_FALSE(cache.Take(1, restored.data()));
+  EXPECT_TRUE(cache.Take(3, restored.data()));
+  EXPECT_EQ(0, strcmp(restored.data(), "page 3"));
+  cache.SetCapacity(0);
+  EXPECT_EQ(0u, cache.GetNumPages());
+}
+
+} // namespace scudb
@@ -0,0 +1,115 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+
+  // push element into replacer, only 1 is accessed twice
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(6);
+  lru_k_replacer.Insert(1);
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // values with less than k accesses go first, oldest first access first
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, lru_k_replacer.Erase(4));
+  EXPECT_EQ(true, lru_k_replacer.Erase(6));
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // pop element from replacer after removal
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, PinKeepsHistoryTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+
+  // 1 is fetched and unpinned twice, 2 and 3 only once but more recently
+  lru_k_replacer.Pin(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Pin(1);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // a scan of once-used values must not push out 1
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+
+  // pinned values are never chosen
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Pin(4);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, PinHitsTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+
+  // 1 was hit twice while pinned, 3 only made non-evictable
+  lru_k_replacer.PinHits(1, 2);
+  lru_k_replacer.PinHits(3, 0);
+  lru_k_replacer.PinHits(4, 0);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // the hits give 1 a finite k-distance, it goes last
+  std::vector<int> values;
+  lru_k_replacer.Peek(values, 10);
+  EXPECT_EQ(std::vector<int>({2, 3, 4, 1}), values);
+}
+
+TEST(LRUKReplacerTest, PeekTest) {
+  LRUKReplacer<int> lru_k_replacer(2);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+
+  // peek lists victims in eviction order and leaves them in place
+  std::vector<int> values;
+  lru_k_replacer.Peek(values, 2);
+  EXPECT_EQ(std::vector<int>({2, 3}), values);
+  values.clear();
+  lru_k_replacer.Peek(values, 10);
+  EXPECT_EQ(std::vector<int>({2, 3, 1}), values);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+}
+
+} // namespace scudb
@@ -0,0 +1,171 @@
+/**
+ * parallel_buffer_pool_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(4, 5, disk_manager);
+  EXPECT_EQ(20, bpm.GetPoolSize());
+
+  // consecutive page ids are spread over all instances
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, temp_page_id);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+  }
+  // all the pages are pinned, the buffer pool is full
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  for (int i = 0; i < 20; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  EXPECT_EQ(false, bpm.UnpinPage(0, true));
+
+  // evict every page, then read them back from disk
+  std::vector<page_id_t> new_pages;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(temp_page_id));
+    new_pages.push_back(temp_page_id);
+  }
+  for (auto page_id : new_pages) {
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+  }
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  EXPECT_EQ(true, bpm.DeletePage(0));
+  EXPECT_EQ(nullptr, bpm.FetchPage(INVALID_PAGE_ID));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(4, 5, disk_manager);
+
+  for (int i = 0; i < 20; ++i) {
+    auto page = bpm.NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm.UnpinPage(temp_page_id, true));
+  }
+
+  // consecutive pages of different instances still make a single run
+  FlushStats stats = bpm.FlushAllPages();
+  EXPECT_EQ(20, stats.num_pages);
+  EXPECT_EQ(20 * PAGE_SIZE, stats.num_bytes);
+  EXPECT_EQ(1, stats.num_writes);
+  char data[PAGE_SIZE];
+  for (int i = 0; i < 20; ++i) {
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ("page " + std::to_string(i), std::string(data));
+  }
+  EXPECT_EQ(0, bpm.FlushAllPages().num_pages);
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const int num_threads = 4;
+  const int num_pages = 50;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(num_threads, 8, disk_manager);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid]() {
+      std::vector<std::pair<page_id_t, std::string>> pages;
+      for (int i = 0; i < num_pages; ++i) {
+        page_id_t page_id;
+        auto page = bpm.NewPage(page_id);
+        ASSERT_NE(nullptr, page);
+        std::string content =
+            std::to_string(tid) + ":" + std::to_string(page_id);
+        snprintf(page->GetData(), PAGE_SIZE, "%s", content.c_str());
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+        pages.emplace_back(page_id, content);
+      }
+      for (auto &entry : pages) {
+        auto page = bpm.FetchPage(entry.first);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(entry.second, std::string(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(entry.first, false));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ParallelBufferPoolManagerTest, ResizeUnderLoadTest) {
+  const int num_threads = 4;
+  const int num_pages = 40;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ParallelBufferPoolManager bpm(2, 8, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&bpm, tid]() {
+      for (int round = 0; round < 20; ++round) {
+        for (int i = tid; i < num_pages; i += num_threads) {
+          auto page = bpm.FetchPage(i);
+          if (page == nullptr) {
+            continue; // the pool shrank below the pinned pages
+          }
+          EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+          EXPECT_EQ(true, bpm.UnpinPage(i, round % 2 == 0));
+        }
+      }
+    }));
+  }
+  for (size_t pool_size : {32, 4, 24, 6, 16}) {
+    bpm.ResizePool(pool_size);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(true, bpm.ResizePool(16));
+  EXPECT_EQ(16, bpm.GetPoolSize());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -0,0 +1,112 @@
+/**
+ * hybrid_latch_test.cpp
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "common/hybrid_latch.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(HybridLatchTest, BasicTest) {
+  int num_threads = 100;
+  int count = 5;
+  HybridLatch latch;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    if (tid % 2 == 0) {
+      threads.push_back(std::thread([&]() {
+        latch.RLock();
+        EXPECT_GE(count, 5);
+        latch.RUnlock();
+      }));
+    } else {
+      threads.push_back(std::thread([&]() {
+        latch.WLock();
+        count += 1;
+        latch.WUnlock();
+      }));
+    }
+  }
+  for (int i = 0; i < num_threads; i++) {
+    threads[i].join();
+  }
+  EXPECT_EQ(55, count);
+}
+
+TEST(HybridLatchTest, OptimisticTest) {
+  HybridLatch latch;
+  uint64_t version;
+  EXPECT_TRUE(latch.TryReadOptimistic(version));
+  EXPECT_TRUE(latch.Validate(version));
+
+  // shared holders do not fail optimistic readers
+  latch.RLock();
+  EXPECT_TRUE(latch.Validate(version));
+  latch.RUnlock();
+
+  // a writer does, from the moment it latches
+  latch.WLock();
+  uint64_t during;
+  EXPECT_FALSE(latch.TryReadOptimistic(during));
+  EXPECT_FALSE(latch.Validate(version));
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(version));
+  EXPECT_TRUE(latch.TryReadOptimistic(version));
+  EXPECT_TRUE(latch.Validate(version));
+}
+
+// writers keep two halves equal, a validated optimistic read must see them so
+TEST(HybridLatchTest, ConcurrentOptimisticTest) {
+  HybridLatch latch;
+  std::atomic<int> left{0};
+  std::atomic<int> right{0};
+  std::atomic<bool> done{false};
+  std::atomic<int> validated{0};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.push_back(std::thread([&]() {
+      while (!done) {
+        uint64_t version;
+        if (!latch.TryReadOptimistic(version)) {
+          continue;
+        }
+        int l = left.load(std::memory_order_relaxed);
+        int r = right.load(std::memory_order_relaxed);
+        if (latch.Validate(version)) {
+          EXPECT_EQ(l, r);
+          validated++;
+        }
+      }
+    }));
+  }
+  std::vector<std::thread> writers;
+  for (int tid = 0; tid < 2; tid++) {
+    writers.push_back(std::thread([&]() {
+      for (int i = 0; i < 10000; i++) {
+        latch.WLock();
+        left.store(left.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+        right.store(right.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+        latch.WUnlock();
+      }
+    }));
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  while (validated == 0) {
+    std::this_thread::yield();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(20000, left.load());
+  EXPECT_EQ(20000, right.load());
+}
+} // namespace scudb
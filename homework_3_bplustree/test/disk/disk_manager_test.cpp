@@ -0,0 +1,173 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "disk/async_io_engine.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskManagerTest, ReadWriteTest) {
+  remove("test.db");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  std::vector<char> data(PAGE_SIZE, 0);
+  std::vector<char> buffer(PAGE_SIZE, 1);
+  // nothing written yet, pages read as zeros
+  EXPECT_EQ(0, disk_manager->GetNumPages());
+  disk_manager->ReadPage(0, buffer.data());
+  EXPECT_EQ(data, buffer);
+
+  snprintf(data.data(), PAGE_SIZE, "page 3");
+  disk_manager->WritePage(3, data.data());
+  disk_manager->Sync();
+  EXPECT_EQ(4, disk_manager->GetNumPages());
+  disk_manager->ReadPage(3, buffer.data());
+  EXPECT_EQ(data, buffer);
+  delete disk_manager;
+
+  // the size of the file is known after a restart, new pages go after it
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(4, disk_manager->GetNumPages());
+  disk_manager->ReadPage(3, buffer.data());
+  EXPECT_EQ(data, buffer);
+  EXPECT_EQ(4, disk_manager->AllocatePage());
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// threads do not share a file position
+TEST(DiskManagerTest, ConcurrentIOTest) {
+  remove("test.db");
+  DiskManager disk_manager("test.db");
+  const int num_threads = 8;
+  const int pages_per_thread = 32;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([&disk_manager, tid]() {
+      std::vector<char> data(PAGE_SIZE);
+      std::vector<char> buffer(PAGE_SIZE);
+      for (int round = 0; round < 4; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id = i * num_threads + tid;
+          snprintf(data.data(), PAGE_SIZE, "page %d round %d", page_id, round);
+          disk_manager.WritePage(page_id, data.data());
+          disk_manager.ReadPage(page_id, buffer.data());
+          EXPECT_EQ(std::string(data.data()), std::string(buffer.data()));
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  disk_manager.Sync();
+  EXPECT_EQ(num_threads * pages_per_thread, disk_manager.GetNumPages());
+  remove("test.db");
+  remove("test.log");
+}
+
+// both engines, the io_uring one may fall back to the thread pool here
+TEST(DiskManagerTest, AsyncIOEngineTest) {
+  remove("test.db");
+  int fd = open("test.db", O_RDWR | O_CREAT, 0644);
+  ASSERT_LE(0, fd);
+  for (bool use_io_uring : {false, true}) {
+    AsyncIOEngine *engine = AsyncIOEngine::Create(use_io_uring);
+    if (!use_io_uring) {
+      EXPECT_STREQ("thread_pool", engine->GetName());
+    }
+    const int num_pages = 100;
+    std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+    std::atomic<int> written{0};
+    for (int i = 0; i < num_pages; ++i) {
+      snprintf(pages[i].data(), PAGE_SIZE, "%s page %d", engine->GetName(), i);
+      std::unique_ptr<AsyncIORequest> request(new AsyncIORequest);
+      request->is_write = true;
+      request->fd = fd;
+      request->offset = static_cast<off_t>(i) * PAGE_SIZE;
+      request->iovs.push_back({pages[i].data(), PAGE_SIZE});
+      request->callback = [&written](ssize_t result) {
+        EXPECT_EQ(static_cast<ssize_t>(PAGE_SIZE), result);
+        written++;
+      };
+      engine->Submit(std::move(request));
+    }
+    // deleting the engine waits for the requests in flight
+    delete engine;
+    EXPECT_EQ(num_pages, written.load());
+
+    engine = AsyncIOEngine::Create(use_io_uring);
+    std::vector<std::vector<char>> buffers(num_pages,
+                                           std::vector<char>(PAGE_SIZE));
+    for (int i = 0; i <= num_pages; ++i) {
+      std::unique_ptr<AsyncIORequest> request(new AsyncIORequest);
+      request->fd = fd;
+      request->offset = static_cast<off_t>(i) * PAGE_SIZE;
+      char *buffer = i < num_pages ? buffers[i].data() : pages[0].data();
+      request->iovs.push_back({buffer, PAGE_SIZE});
+      request->callback = [i](ssize_t result) {
+        // the end of the file
+        EXPECT_EQ(i < num_pages ? static_cast<ssize_t>(PAGE_SIZE) : 0, result);
+      };
+      engine->Submit(std::move(request));
+    }
+    delete engine;
+    EXPECT_EQ(pages, buffers);
+  }
+  close(fd);
+  remove("test.db");
+}
+
+TEST(DiskManagerTest, AsyncPageIOTest) {
+  remove("test.db");
+  DiskManager disk_manager("test.db");
+  const int num_pages = 64;
+  std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<const char *> run;
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(pages[i].data(), PAGE_SIZE, "page %d", i);
+    run.push_back(pages[i].data());
+  }
+  std::mutex latch;
+  std::condition_variable cv;
+  int done = 0;
+  auto callback = [&] {
+    std::lock_guard<std::mutex> guard(latch);
+    done++;
+    cv.notify_all();
+  };
+  disk_manager.WritePagesAsync(0, run, callback);
+  {
+    std::unique_lock<std::mutex> lock(latch);
+    cv.wait(lock, [&] { return done == 1; });
+  }
+  EXPECT_EQ(num_pages, disk_manager.GetNumPages());
+
+  std::vector<std::vector<char>> buffers(num_pages,
+                                         std::vector<char>(PAGE_SIZE));
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager.ReadPageAsync(i, buffers[i].data(), callback);
+  }
+  {
+    std::unique_lock<std::mutex> lock(latch);
+    cv.wait(lock, [&] { return done == 1 + num_pages; });
+  }
+  EXPECT_EQ(pages, buffers);
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace scudb
@@ -0,0 +1,111 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "hash/page_table.h"
+#include "page/page.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(PageTableTest, SampleTest) {
+  std::vector<Page> frames(4);
+  PageTable table(4);
+  Page *frame = nullptr;
+  EXPECT_FALSE(table.Find(0, frame));
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(table.Insert(i, &frames[i]));
+  }
+  EXPECT_EQ(4, table.GetSize());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(table.Find(i, frame));
+    EXPECT_EQ(&frames[i], frame);
+  }
+
+  // insert of a present page id is refused, it keeps its frame
+  EXPECT_FALSE(table.Insert(1, &frames[3]));
+  EXPECT_EQ(4, table.GetSize());
+  EXPECT_TRUE(table.Find(1, frame));
+  EXPECT_EQ(&frames[1], frame);
+
+  EXPECT_TRUE(table.Remove(1));
+  EXPECT_FALSE(table.Remove(1));
+  EXPECT_FALSE(table.Remove(INVALID_PAGE_ID));
+  EXPECT_FALSE(table.Find(INVALID_PAGE_ID, frame));
+  EXPECT_FALSE(table.Find(1, frame));
+  EXPECT_EQ(3, table.GetSize());
+}
+
+TEST(PageTableTest, GrowAndRemoveTest) {
+  std::vector<Page> frames(1);
+  PageTable table(8);
+  EXPECT_EQ(8, table.GetCapacity());
+
+  // long probe sequences, then remove every other entry: the entries after
+  // each removed one must still be found
+  const int num_pages = 1000;
+  for (int i = 0; i < num_pages; ++i) {
+    table.Insert(i, &frames[0]);
+  }
+  EXPECT_EQ(num_pages, table.GetSize());
+  EXPECT_LE(num_pages, table.GetCapacity());
+  for (int i = 0; i < num_pages; i += 2) {
+    EXPECT_TRUE(table.Remove(i));
+  }
+  Page *frame = nullptr;
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ(i % 2 == 1, table.Find(i, frame)) << i;
+  }
+  for (int i = 1; i < num_pages; i += 2) {
+    EXPECT_TRUE(table.Remove(i));
+  }
+  EXPECT_EQ(0, table.GetSize());
+}
+
+TEST(PageTableTest, ConcurrentFindTest) {
+  std::vector<Page> frames(2);
+  PageTable table(4);
+  // page ids below 64 stay mapped to frames[0] while the writer churns and
+  // grows the table: readers may miss them, but never get another frame
+  for (int i = 0; i < 64; ++i) {
+    table.Insert(i, &frames[0]);
+  }
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; ++tid) {
+    readers.push_back(std::thread([&] {
+      Page *frame = nullptr;
+      while (!done) {
+        for (int i = 0; i < 64; ++i) {
+          if (table.Find(i, frame)) {
+            EXPECT_EQ(&frames[0], frame);
+          }
+        }
+      }
+    }));
+  }
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 64; i < 64 + 100 * round; ++i) {
+      table.Insert(i, &frames[1]);
+    }
+    for (int i = 64; i < 64 + 100 * round; ++i) {
+      table.Remove(i);
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(64, table.GetSize());
+  Page *frame = nullptr;
+  for (int i = 0; i < 64; ++i) {
+    EXPECT_TRUE(table.Find(i, frame));
+  }
+}
+
+} // namespace scudb
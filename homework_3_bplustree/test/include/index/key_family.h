@@ -0,0 +1,25 @@
+/**
+ * key_family.h
+ *
+ * Key types the B+ tree tests run on, as gtest type parameters: the schema
+ * compared GenericKey and the native IntegerKey. Both hold a bigint.
+ */
+
+#pragma once
+
+#include "index/b_plus_tree.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+template <typename Key, typename Comparator> struct KeyFamily {
+  using KeyType = Key;
+  using KeyComparator = Comparator;
+  using Tree = BPlusTree<Key, RID, Comparator>;
+};
+
+using KeyFamilies = ::testing::Types<
+    KeyFamily<GenericKey<8>, GenericComparator<8>>,
+    KeyFamily<IntegerKey<int64_t>, IntegerComparator<int64_t>>>;
+
+} // namespace scudb
@@ -10,8 +10,10 @@
 #include <thread>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "index/key_family.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -33,10 +35,11 @@ void LaunchParallelTest(uint64_t num_threads, Args &&... args) {
 }
 
 // helper function to insert
-void InsertHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+template <typename Family>
+void InsertHelper(typename Family::Tree &tree,
                   const std::vector<int64_t> &keys,
                   __attribute__((unused)) uint64_t thread_itr = 0) {
-  GenericKey<8> index_key;
+  typename Family::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -50,11 +53,11 @@ void InsertHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
 }
 
 // helper function to seperate insert
-void InsertHelperSplit(
-    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
-    const std::vector<int64_t> &keys, int total_threads,
-    __attribute__((unused)) uint64_t thread_itr) {
-  GenericKey<8> index_key;
+template <typename Family>
+void InsertHelperSplit(typename Family::Tree &tree,
+                       const std::vector<int64_t> &keys, int total_threads,
+                       __attribute__((unused)) uint64_t thread_itr) {
+  typename Family::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -70,10 +73,11 @@ void InsertHelperSplit(
 }
 
 // helper function to delete
-void DeleteHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+template <typename Family>
+void DeleteHelper(typename Family::Tree &tree,
                   const std::vector<int64_t> &remove_keys,
                   __attribute__((unused)) uint64_t thread_itr = 0) {
-  GenericKey<8> index_key;
+  typename Family::KeyType index_key;
   // create transaction
   Transaction *transaction = new Transaction(0);
   for (auto key : remove_keys) {
@@ -84,11 +88,12 @@ void DeleteHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
 }
 
 // helper function to seperate delete
-void DeleteHelperSplit(
-    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
-    const std::vector<int64_t> &remove_keys, int total_threads,
-    __attribute__((unused)) uint64_t thread_itr) {
-  GenericKey<8> index_key;
+template <typename Family>
+void DeleteHelperSplit(typename Family::Tree &tree,
+                       const std::vector<int64_t> &remove_keys,
+                       int total_threads,
+                       __attribute__((unused)) uint64_t thread_itr) {
+  typename Family::KeyType index_key;
   // create transaction
   Transaction *transaction = new Transaction(0);
   for (auto key : remove_keys) {
@@ -100,16 +105,37 @@ void DeleteHelperSplit(
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, InsertTest1) {
+// helper function to look keys up, all of them must be found
+template <typename Family>
+void LookupHelper(typename Family::Tree &tree,
+                  const std::vector<int64_t> &keys,
+                  __attribute__((unused)) uint64_t thread_itr = 0) {
+  typename Family::KeyType index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), 1);
+    if (rids.size() == 1) {
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+  }
+}
+
+template <typename Family>
+class BPlusTreeConcurrentTest : public ::testing::Test {};
+TYPED_TEST_CASE(BPlusTreeConcurrentTest, KeyFamilies);
+
+TYPED_TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
   // create and fetch header_page
   page_id_t page_id;
   auto header_page = bpm->NewPage(page_id);
@@ -120,10 +146,10 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   for (int64_t key = 1; key < scale_factor; key++) {
     keys.push_back(key);
   }
-  LaunchParallelTest(2, InsertHelper, std::ref(tree), keys);
+  LaunchParallelTest(2, InsertHelper<TypeParam>, std::ref(tree), keys);
 
   std::vector<RID> rids;
-  GenericKey<8> index_key;
+  typename TypeParam::KeyType index_key;
   for (auto key : keys) {
     rids.clear();
     index_key.SetFromInteger(key);
@@ -155,15 +181,14 @@ TEST(BPlusTreeConcurrentTest, InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, InsertTest2) {
+TYPED_TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
   // create and fetch header_page
   page_id_t page_id;
   auto header_page = bpm->NewPage(page_id);
@@ -174,10 +199,10 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   for (int64_t key = 1; key < scale_factor; key++) {
     keys.push_back(key);
   }
-  LaunchParallelTest(2, InsertHelperSplit, std::ref(tree), keys, 2);
+  LaunchParallelTest(2, InsertHelperSplit<TypeParam>, std::ref(tree), keys, 2);
 
   std::vector<RID> rids;
-  GenericKey<8> index_key;
+  typename TypeParam::KeyType index_key;
   for (auto key : keys) {
     rids.clear();
     index_key.SetFromInteger(key);
@@ -209,17 +234,16 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DeleteTest1) {
+TYPED_TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create and fetch header_page
   page_id_t page_id;
@@ -227,10 +251,10 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   (void)header_page;
   // sequential insert
   std::vector<int64_t> keys = {1, 2, 3, 4, 5};
-  InsertHelper(tree, keys);
+  InsertHelper<TypeParam>(tree, keys);
 
   std::vector<int64_t> remove_keys = {1, 5, 3, 4};
-  LaunchParallelTest(2, DeleteHelper, std::ref(tree), remove_keys);
+  LaunchParallelTest(2, DeleteHelper<TypeParam>, std::ref(tree), remove_keys);
 
   int64_t start_key = 2;
   int64_t current_key = start_key;
@@ -255,17 +279,16 @@ TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DeleteTest2) {
+TYPED_TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create and fetch header_page
   page_id_t page_id;
@@ -274,10 +297,11 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
 
   // sequential insert
   std::vector<int64_t> keys = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
-  InsertHelper(tree, keys);
+  InsertHelper<TypeParam>(tree, keys);
 
   std::vector<int64_t> remove_keys = {1, 4, 3, 2, 5, 6};
-  LaunchParallelTest(2, DeleteHelperSplit, std::ref(tree), remove_keys, 2);
+  LaunchParallelTest(2, DeleteHelperSplit<TypeParam>, std::ref(tree),
+                     remove_keys, 2);
 
   int64_t start_key = 7;
   int64_t current_key = start_key;
@@ -301,17 +325,16 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, MixTest) {
+TYPED_TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
 
   // create and fetch header_page
@@ -320,16 +343,16 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   (void)header_page;
   // first, populate index
   std::vector<int64_t> keys = {1, 2, 3, 4, 5};
-  InsertHelper(tree, keys);
+  InsertHelper<TypeParam>(tree, keys);
 
   // concurrent insert
   keys.clear();
   for (int i = 6; i <= 10; i++)
     keys.push_back(i);
-  LaunchParallelTest(1, InsertHelper, std::ref(tree), keys);
+  LaunchParallelTest(1, InsertHelper<TypeParam>, std::ref(tree), keys);
   // concurrent delete
   std::vector<int64_t> remove_keys = {1, 4, 3, 5, 6};
-  LaunchParallelTest(1, DeleteHelper, std::ref(tree), remove_keys);
+  LaunchParallelTest(1, DeleteHelper<TypeParam>, std::ref(tree), remove_keys);
 
   int64_t start_key = 2;
   int64_t size = 0;
@@ -348,4 +371,171 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+/*
+ * Lookups descend optimistically while a writer splits the nodes they read,
+ * and the small pool keeps evicting them
+ */
+TYPED_TEST(BPlusTreeConcurrentTest, LookupDuringInsertTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  typename TypeParam::KeyComparator comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  // create b+ tree
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<int64_t> present_keys;
+  std::vector<int64_t> new_keys;
+  for (int64_t key = 1; key < 2000; key++) {
+    if (key % 2 == 0) {
+      present_keys.push_back(key);
+    } else {
+      new_keys.push_back(key);
+    }
+  }
+  InsertHelper<TypeParam>(tree, present_keys);
+
+  std::thread writer(InsertHelper<TypeParam>, std::ref(tree), new_keys, 0);
+  LaunchParallelTest(4, LookupHelper<TypeParam>, std::ref(tree), present_keys);
+  writer.join();
+  LookupHelper<TypeParam>(tree, new_keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Writers split and merge the same pages at once: half of the threads insert
+ * the odd keys while the other half removes the even ones, then all the odd
+ * keys and only them must be left, in order
+ */
+TYPED_TEST(BPlusTreeConcurrentTest, InsertDuringDeleteTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  typename TypeParam::KeyComparator comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<int64_t> odd_keys;
+  std::vector<int64_t> even_keys;
+  for (int64_t key = 1; key < 4000; key++) {
+    if (key % 2 == 0) {
+      even_keys.push_back(key);
+    } else {
+      odd_keys.push_back(key);
+    }
+  }
+  InsertHelper<TypeParam>(tree, even_keys);
+
+  std::vector<std::thread> threads;
+  for (uint64_t thread_itr = 0; thread_itr < 4; thread_itr++) {
+    threads.push_back(std::thread(InsertHelperSplit<TypeParam>, std::ref(tree),
+                                  odd_keys, 4, thread_itr));
+    threads.push_back(std::thread(DeleteHelperSplit<TypeParam>, std::ref(tree),
+                                  even_keys, 4, thread_itr));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  LookupHelper<TypeParam>(tree, odd_keys);
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(current_key, 4001);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+/*
+ * Run the split insert/delete workloads on a sharded buffer pool with 1 to N
+ * threads, writers finding their leaf by read latch crabbing from the root,
+ * then with an optimistic descent. Check the tree contents after each run
+ */
+TYPED_TEST(BPlusTreeConcurrentTest, ParallelBufferPoolScaleTest) {
+  const uint64_t max_threads = 8;
+  const int64_t scale_factor = 2000;
+  bool enable_optimistic_writes = ENABLE_OPTIMISTIC_WRITES;
+
+  for (bool optimistic : {false, true}) {
+    ENABLE_OPTIMISTIC_WRITES = optimistic;
+    for (uint64_t num_threads = 1; num_threads <= max_threads;
+         num_threads *= 2) {
+      // create KeyComparator and index schema
+      Schema *key_schema = ParseCreateStatement("a bigint");
+      typename TypeParam::KeyComparator comparator(key_schema);
+
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm =
+          new ParallelBufferPoolManager(max_threads, 32, disk_manager);
+      // create b+ tree
+      typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+      // create and fetch header_page
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(page_id);
+      (void)header_page;
+
+      std::vector<int64_t> keys;
+      for (int64_t key = 1; key < scale_factor; key++) {
+        keys.push_back(key);
+      }
+      LaunchParallelTest(num_threads, InsertHelperSplit<TypeParam>,
+                         std::ref(tree), keys, num_threads);
+
+      int64_t current_key = 1;
+      typename TypeParam::KeyType index_key;
+      index_key.SetFromInteger(current_key);
+      for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+           ++iterator) {
+        EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+        current_key = current_key + 1;
+      }
+      EXPECT_EQ(current_key, scale_factor);
+
+      // remove the first half of the keys
+      std::vector<int64_t> remove_keys(keys.begin(),
+                                       keys.begin() + keys.size() / 2);
+      LaunchParallelTest(num_threads, DeleteHelperSplit<TypeParam>,
+                         std::ref(tree), remove_keys, num_threads);
+
+      int64_t size = 0;
+      for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+           ++iterator) {
+        EXPECT_GT((*iterator).first.ToString(), remove_keys.back());
+        size = size + 1;
+      }
+      EXPECT_EQ(size, keys.size() - remove_keys.size());
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete key_schema;
+      delete bpm;
+      delete disk_manager;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+  ENABLE_OPTIMISTIC_WRITES = enable_optimistic_writes;
+}
+
 } // namespace scudb
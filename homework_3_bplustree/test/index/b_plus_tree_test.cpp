@@ -10,22 +10,25 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "index/key_family.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
 namespace scudb {
 
-TEST(BPlusTreeTests, InsertTest1) {
+template <typename Family> class BPlusTreeTests : public ::testing::Test {};
+TYPED_TEST_CASE(BPlusTreeTests, KeyFamilies);
+
+TYPED_TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -75,17 +78,16 @@ TEST(BPlusTreeTests, InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, InsertTest2) {
+TYPED_TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -146,18 +148,17 @@ TEST(BPlusTreeTests, InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DeleteTest1) {
+TYPED_TEST(BPlusTreeTests, DeleteTest1) {
   // create KeyComparator and index schema
   std::string createStmt = "a bigint";
   Schema *key_schema = ParseCreateStatement(createStmt);
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -228,17 +229,16 @@ TEST(BPlusTreeTests, DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DeleteTest2) {
+TYPED_TEST(BPlusTreeTests, DeleteTest2) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -309,17 +309,16 @@ TEST(BPlusTreeTests, DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, ScaleTest) {
+TYPED_TEST(BPlusTreeTests, ScaleTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
-  GenericComparator<8> comparator(key_schema);
+  typename TypeParam::KeyComparator comparator(key_schema);
 
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
   // create b+ tree
-  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
-                                                           comparator);
-  GenericKey<8> index_key;
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
   RID rid;
   // create transaction
   Transaction *transaction = new Transaction(0);
@@ -390,4 +389,55 @@ TEST(BPlusTreeTests, ScaleTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TYPED_TEST(BPlusTreeTests, LargePageTest) {
+  // page capacities follow the runtime page size
+  PAGE_SIZE = 4096;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  typename TypeParam::KeyComparator comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  typename TypeParam::Tree tree("foo_pk", bpm, comparator);
+  typename TypeParam::KeyType index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // a 4096 byte leaf holds more than 200 keys of 8 bytes
+  for (int64_t key = 1; key <= 200; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  auto root = reinterpret_cast<BPlusTreePage *>(
+      bpm->FetchPage(tree.GetRootPageId())->GetData());
+  EXPECT_TRUE(root->IsLeafPage());
+  bpm->UnpinPage(tree.GetRootPageId(), false);
+
+  for (int64_t key = 201; key <= 10000; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 10000; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+}
 } // namespace scudb
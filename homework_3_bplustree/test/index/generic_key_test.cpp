@@ -0,0 +1,94 @@
+/**
+ * generic_key_test.cpp
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "index/generic_key.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+static int Sign(int value) { return (value > 0) - (value < 0); }
+
+// random keys of a small domain, so that the first columns often tie
+static std::vector<Tuple> MakeKeys(Schema *key_schema, int num_keys) {
+  std::mt19937 random(0);
+  const std::vector<std::string> strings = {"",   "a",    "ab",  "abc",
+                                            "b",  "ba",   "zz",  "a b",
+                                            "A",  "abcd", "~",   "0"};
+  const std::vector<double> decimals = {-2.5, -1, -0.0, 0, 0.25, 1, 1e300};
+  std::vector<Tuple> keys;
+  for (int i = 0; i < num_keys; ++i) {
+    std::vector<Value> values;
+    values.emplace_back(TypeId::INTEGER,
+                        static_cast<int32_t>(random() % 7) - 3);
+    values.emplace_back(TypeId::VARCHAR,
+                        strings[random() % strings.size()]);
+    values.emplace_back(TypeId::DECIMAL, decimals[random() % decimals.size()]);
+    values.emplace_back(TypeId::SMALLINT,
+                        static_cast<int16_t>(random() % 600 - 300));
+    keys.emplace_back(values, key_schema);
+  }
+  return keys;
+}
+
+// the memcmp order of normalized keys is the column by column order
+TEST(GenericKeyTest, NormalizedOrderTest) {
+  Schema *key_schema =
+      ParseCreateStatement("a integer, b varchar(8), c double, d smallint");
+  GenericComparator<32> comparator(key_schema);
+  GenericComparator<32> normalized_comparator(key_schema, true);
+  std::vector<Tuple> tuples = MakeKeys(key_schema, 200);
+  std::vector<GenericKey<32>> keys(tuples.size());
+  std::vector<GenericKey<32>> normalized_keys(tuples.size());
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    keys[i].SetFromKey(tuples[i]);
+    normalized_keys[i].SetFromKey(tuples[i], key_schema);
+  }
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    for (size_t j = 0; j < tuples.size(); ++j) {
+      EXPECT_EQ(Sign(comparator(keys[i], keys[j])),
+                Sign(normalized_comparator(normalized_keys[i],
+                                           normalized_keys[j])))
+          << tuples[i].ToString(key_schema) << " "
+          << tuples[j].ToString(key_schema);
+    }
+  }
+  delete key_schema;
+}
+
+/*
+ * Many more pairs of multi-column keys, compared through the key schema and
+ * as normalized keys, add up to the same signs
+ */
+TEST(GenericKeyTest, NormalizedCompareTest) {
+  const int num_compares = 200000;
+  Schema *key_schema =
+      ParseCreateStatement("a integer, b varchar(8), c double, d smallint");
+  GenericComparator<32> comparator(key_schema);
+  GenericComparator<32> normalized_comparator(key_schema, true);
+  std::vector<Tuple> tuples = MakeKeys(key_schema, 1024);
+  std::vector<GenericKey<32>> keys(tuples.size());
+  std::vector<GenericKey<32>> normalized_keys(tuples.size());
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    keys[i].SetFromKey(tuples[i]);
+    normalized_keys[i].SetFromKey(tuples[i], key_schema);
+  }
+
+  int64_t checksum[2] = {0, 0};
+  for (int i = 0; i < num_compares; ++i) {
+    checksum[0] += Sign(comparator(keys[i % 1024], keys[(i * 7 + 1) % 1024]));
+  }
+  for (int i = 0; i < num_compares; ++i) {
+    checksum[1] += Sign(normalized_comparator(normalized_keys[i % 1024],
+                                              normalized_keys[(i * 7 + 1) % 1024]));
+  }
+  EXPECT_EQ(checksum[0], checksum[1]);
+  delete key_schema;
+}
+
+} // namespace scudb
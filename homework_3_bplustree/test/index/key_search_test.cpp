@@ -0,0 +1,122 @@
+/**
+ * key_search_test.cpp
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "common/rid.h"
+#include "index/key_search.h"
+#include "page/b_plus_tree_leaf_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// hides GenericComparator from the integer search
+template <size_t KeySize> struct OpaqueComparator {
+  inline int operator()(const GenericKey<KeySize> &lhs,
+                        const GenericKey<KeySize> &rhs) const {
+    return comparator(lhs, rhs);
+  }
+  GenericComparator<KeySize> comparator;
+};
+
+// SetFromInteger() writes 8 bytes, a small value fits in 4 as well
+template <size_t KeySize>
+static void SetKey(GenericKey<KeySize> &key, int64_t value) {
+  memset(key.data, 0, KeySize);
+  memcpy(key.data, &value, std::min(KeySize, sizeof(value)));
+}
+
+template <size_t KeySize>
+static void CheckBounds(const char *sql, int n) {
+  Schema *key_schema = ParseCreateStatement(sql);
+  GenericComparator<KeySize> comparator(key_schema);
+  OpaqueComparator<KeySize> opaque{comparator};
+  using Pair = std::pair<GenericKey<KeySize>, RID>;
+  std::vector<Pair> array(n);
+  std::vector<int64_t> keys;
+  for (int i = 0; i < n; ++i) {
+    keys.push_back(2 * i - n);
+    SetKey(array[i].first, keys.back());
+  }
+  for (int64_t value = -n - 2; value <= n + 1; ++value) {
+    GenericKey<KeySize> key;
+    SetKey(key, value);
+    for (bool upper : {false, true}) {
+      int expected =
+          static_cast<int>((upper ? std::upper_bound(keys.begin(), keys.end(),
+                                                     value)
+                                  : std::lower_bound(keys.begin(), keys.end(),
+                                                     value)) -
+                           keys.begin());
+      EXPECT_EQ(expected,
+                (KeySearch<GenericKey<KeySize>, RID, GenericComparator<KeySize>>::
+                     Bound(array.data(), 0, n, key, comparator, upper)));
+      EXPECT_EQ(expected,
+                (KeySearch<GenericKey<KeySize>, RID, OpaqueComparator<KeySize>>::
+                     Bound(array.data(), 0, n, key, opaque, upper)));
+    }
+  }
+  delete key_schema;
+}
+
+TEST(KeySearchTest, BoundTest) {
+  for (int n : {0, 1, 3, 4, 8, 15, 16, 17, 33, 100, 257}) {
+    CheckBounds<4>("a integer", n);
+    CheckBounds<8>("a bigint", n);
+    CheckBounds<16>("a bigint", n);
+  }
+}
+
+/*
+ * At the fanout of a leaf page of each page size, a linear scan with the
+ * comparator, the binary search with the comparator and the integer search
+ * find the same positions
+ */
+TEST(KeySearchTest, NodeSearchTest) {
+  using Leaf = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+  using Pair = std::pair<GenericKey<8>, RID>;
+  const int num_searches = 10000;
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  OpaqueComparator<8> opaque{comparator};
+  std::mt19937 random(0);
+
+  for (size_t page_size = MIN_PAGE_SIZE; page_size <= MAX_PAGE_SIZE;
+       page_size *= 2) {
+    int fanout = static_cast<int>((page_size - sizeof(Leaf)) / sizeof(Pair));
+    std::vector<Pair> array(fanout);
+    for (int i = 0; i < fanout; ++i) {
+      array[i].first.SetFromInteger(2 * i);
+    }
+    std::vector<GenericKey<8>> keys(num_searches);
+    for (auto &key : keys) {
+      key.SetFromInteger(random() % (2 * fanout));
+    }
+
+    int64_t checksum[3] = {0, 0, 0};
+    for (auto &key : keys) {
+      int index = 0;
+      while (index < fanout && comparator(array[index].first, key) < 0) {
+        ++index;
+      }
+      checksum[0] += index;
+    }
+    for (auto &key : keys) {
+      checksum[1] += KeySearch<GenericKey<8>, RID, OpaqueComparator<8>>::Bound(
+          array.data(), 0, fanout, key, opaque, false);
+    }
+    for (auto &key : keys) {
+      checksum[2] += KeySearch<GenericKey<8>, RID, GenericComparator<8>>::Bound(
+          array.data(), 0, fanout, key, comparator, false);
+    }
+    EXPECT_EQ(checksum[0], checksum[1]);
+    EXPECT_EQ(checksum[0], checksum[2]);
+  }
+  delete key_schema;
+}
+
+} // namespace scudb
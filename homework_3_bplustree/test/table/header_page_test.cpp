@@ -5,11 +5,11 @@
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace scudb {
 
 TEST(HeaderPageTest, UnitTest) {
+  // 27 records need a page of at least 4096 bytes
+  PAGE_SIZE = 4096;
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
@@ -17,7 +17,7 @@ TEST(HeaderPageTest, UnitTest) {
   HeaderPage *page =
       static_cast<HeaderPage *>(buffer_pool_manager->NewPage(header_page_id));
   ASSERT_NE(nullptr, page);
-  page->Init();
+  page->Init(HeaderPage::FREE_SPACE_MAP);
 
   for (int i = 1; i < 28; i++) {
     std::string name = std::to_string(i);
@@ -49,10 +49,14 @@ TEST(HeaderPageTest, UnitTest) {
   }
 
   EXPECT_EQ(page->GetRecordCount(), 0);
+  EXPECT_EQ(4096, page->GetPageSize());
+  EXPECT_EQ(HeaderPage::FREE_SPACE_MAP, page->GetFlags());
+  EXPECT_EQ(BUFFER_POOL_SIZE, page->GetPoolSize());
 
   delete buffer_pool_manager;
   delete disk_manager;
   remove("test.db");
   remove("test.log");
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
 }
 } // namespace scudb
@@ -0,0 +1,95 @@
+/**
+ * storage_engine_test.cpp
+ */
+
+#include <cstdio>
+#include <string>
+
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+// freed pages are only reused in a database created with bitmap pages, a
+// database written before them keeps its page 1
+TEST(StorageEngineTest, FreeSpaceMapFlagTest) {
+  remove("test.db");
+  StorageEngine *storage_engine = new StorageEngine("test.db");
+  EXPECT_TRUE(storage_engine->free_space_map_);
+  EXPECT_TRUE(storage_engine->blink_pages_);
+  delete storage_engine;
+  remove("test.db");
+
+  // a database of before the flag, page 1 holds data
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t page_id;
+  auto *header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  Page *page = bpm->NewPage(page_id);
+  EXPECT_EQ(1, page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "page 1");
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  storage_engine = new StorageEngine("test.db");
+  EXPECT_FALSE(storage_engine->free_space_map_);
+  EXPECT_FALSE(storage_engine->blink_pages_);
+  bpm = storage_engine->buffer_pool_manager_;
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(2, page_id);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  EXPECT_EQ(true, bpm->DeletePage(page_id));
+  page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("page 1", std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+  delete storage_engine;
+
+  remove("test.db");
+  remove("test.log");
+  remove("test.warm");
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+}
+
+// a reopened database allocates right after its last page, whatever the page
+// size was before it was opened
+TEST(StorageEngineTest, ReopenPageSizeTest) {
+  remove("test.db");
+  for (size_t page_size : {MAX_PAGE_SIZE, MIN_PAGE_SIZE}) {
+    PAGE_SIZE = page_size == MIN_PAGE_SIZE ? MAX_PAGE_SIZE : MIN_PAGE_SIZE;
+    StorageEngine *storage_engine = new StorageEngine("test.db", page_size);
+    BufferPoolManager *bpm = storage_engine->buffer_pool_manager_;
+    page_id_t page_id;
+    auto *header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+    ASSERT_NE(nullptr, header_page);
+    header_page->Init(HeaderPage::FREE_SPACE_MAP);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_id));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    }
+    EXPECT_EQ(4, page_id);
+    delete storage_engine;
+
+    PAGE_SIZE = page_size == MIN_PAGE_SIZE ? MAX_PAGE_SIZE : MIN_PAGE_SIZE;
+    storage_engine = new StorageEngine("test.db");
+    EXPECT_EQ(page_size, PAGE_SIZE);
+    bpm = storage_engine->buffer_pool_manager_;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    EXPECT_EQ(5, page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+    delete storage_engine;
+    remove("test.db");
+    remove("test.log");
+    remove("test.warm");
+  }
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+}
+} // namespace scudb
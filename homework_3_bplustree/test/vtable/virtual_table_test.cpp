@@ -1,6 +1,11 @@
 /**
  * virtual_table_test.cpp
  */
+#include <fstream>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "page/header_page.h"
 #include "vtable/testing_vtable_util.h"
 
 namespace scudb {
@@ -12,6 +17,7 @@ TEST(VtableTest, CreateTest) {
   std::string db_file = "sqlite.db";
   remove(db_file.c_str());
   remove("vtable.db");
+  remove("vtable.warm");
   sqlite3 *db;
   int rc;
   rc = sqlite3_open(db_file.c_str(), &db);
@@ -42,6 +48,197 @@ TEST(VtableTest, CreateTest) {
 
   remove(db_file.c_str());
   remove("vtable.db");
+  remove("vtable.warm");
   return;
 }
+
+// module arguments size the storage engine, a reopened database keeps its
+// page size
+TEST(VtableTest, PageSizeTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+  sqlite3 *db;
+  char *zErrMsg = 0;
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT, b "
+                          "varchar', 'foo2_pk a', 'page_size=4096', "
+                          "'pool_size=64')"));
+  EXPECT_EQ(4096, PAGE_SIZE);
+  EXPECT_EQ(64, BUFFER_POOL_SIZE);
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(2, 'world')"));
+  // the page size of a database can not change
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT', "
+                           "'page_size=8192')"));
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT', "
+                           "'page_size=1000')"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+  // a clean shutdown saves the resident pages
+  EXPECT_TRUE(std::ifstream("vtable.warm").is_open());
+
+  // reopen: the page size comes from the header page of vtable.db, the pool
+  // is warmed up with the saved pages
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo2"));
+  EXPECT_EQ(4096, PAGE_SIZE);
+  EXPECT_FALSE(std::ifstream("vtable.warm").is_open());
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+}
+
+// buffer pool stats can be read from SQL
+TEST(VtableTest, BufferStatsTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+  sqlite3 *db;
+  char *zErrMsg = 0;
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT, b "
+                          "varchar', 'foo4_pk a')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo4 WHERE a = 1"));
+
+  sqlite3_stmt *stmt;
+  ASSERT_EQ(sqlite3_prepare_v2(db,
+                               "SELECT name, value FROM scudb_buffer_stats "
+                               "WHERE name IN ('pool_size', 'fetch_hit', "
+                               "'hit_ratio') ORDER BY name",
+                               -1, &stmt, nullptr),
+            SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ("fetch_hit", std::string(reinterpret_cast<const char *>(
+                             sqlite3_column_text(stmt, 0))));
+  EXPECT_LT(0, sqlite3_column_int64(stmt, 1));
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ(SQLITE_FLOAT, sqlite3_column_type(stmt, 1));
+  EXPECT_LT(0, sqlite3_column_double(stmt, 1));
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ((sqlite3_int64)BUFFER_POOL_SIZE, sqlite3_column_int64(stmt, 1));
+  EXPECT_EQ(sqlite3_step(stmt), SQLITE_DONE);
+  sqlite3_finalize(stmt);
+  // read only
+  EXPECT_FALSE(ExecSQL(db, "DELETE FROM scudb_buffer_stats"));
+
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+}
+
+// number of rows of foo5 with c = value, looked up through the index
+static int CountRows(sqlite3 *db, int value) {
+  sqlite3_stmt *stmt;
+  std::string sql = "SELECT count(*) FROM foo5 WHERE c = " +
+                    std::to_string(value);
+  EXPECT_EQ(sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr),
+            SQLITE_OK);
+  EXPECT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  int count = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+  return count;
+}
+
+// an index reopened empty, then filled, is found again once reopened
+TEST(VtableTest, ReopenIndexTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+  sqlite3 *db;
+  char *zErrMsg = 0;
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo5 USING vtable ('a INT, c "
+                          "smallint', 'foo5_pk c')"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+
+  for (int round = 0; round < 2; ++round) {
+    EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+    EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+    EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+    if (round == 0) {
+      for (int c = 1; c <= 300; ++c) {
+        EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo5 VALUES(0, " +
+                                    std::to_string(c) + ")"));
+      }
+    }
+    for (int c : {1, 255, 256, 257, 300}) {
+      EXPECT_EQ(1, CountRows(db, c));
+    }
+    EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+  }
+
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+}
+
+// indexes of a database created before B-link pages are refused, its tables
+// without an index still work
+TEST(VtableTest, IndexLayoutTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+  sqlite3 *db;
+  char *zErrMsg = 0;
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo6 USING vtable ('a INT, b "
+                          "varchar', 'foo6_pk a')"));
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo7 USING vtable ('a INT')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo6 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo7 VALUES(1)"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+
+  // as if created before B-link pages
+  DiskManager *disk_manager = new DiskManager("vtable.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  auto *header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_NE(0, header_page->GetFlags() & HeaderPage::BLINK_PAGES);
+  header_page->SetFlags(header_page->GetFlags() & ~HeaderPage::BLINK_PAGES);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  EXPECT_EQ(sqlite3_open(db_file.c_str(), &db), SQLITE_OK);
+  EXPECT_EQ(sqlite3_enable_load_extension(db, 1), SQLITE_OK);
+  EXPECT_EQ(sqlite3_load_extension(db, "libvtable", 0, &zErrMsg), SQLITE_OK);
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo7 VALUES(2)"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo7"));
+  EXPECT_FALSE(ExecSQL(db, "SELECT * FROM foo6 WHERE a = 1"));
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo8 USING vtable ('a INT', "
+                           "'foo8_pk a')"));
+  EXPECT_EQ(sqlite3_close(db), SQLITE_OK);
+
+  PAGE_SIZE = DEFAULT_PAGE_SIZE;
+  BUFFER_POOL_SIZE = DEFAULT_BUFFER_POOL_SIZE;
+  remove(db_file.c_str());
+  remove("vtable.db");
+  remove("vtable.warm");
+}
 } // namespace scudb